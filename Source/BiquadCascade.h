@@ -0,0 +1,314 @@
+/*
+  ==============================================================================
+
+    Cascaded biquad processing that doesn't go through juce::dsp::ProcessorChain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <limits>
+#include <vector>
+
+//==============================================================================
+//Plain biquad coefficients, normalised by a0 and laid out like juce::dsp::IIR::Coefficients: b0, b1, b2, a1, a2
+struct BiquadCoeffs
+{
+    double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+};
+
+//Cascade of second order sections for the 12 - 48 dB/Oct cut filters
+struct CutCoeffs
+{
+    static constexpr int maxNumStages = 4;
+
+    std::array<BiquadCoeffs, maxNumStages> stages;
+    int numStages{ 1 };
+};
+
+//How many samples the impulse response of a section takes to decay by 'decayDecibels', from its pole radius
+inline double getDecaySamples(const BiquadCoeffs& coefficients, double decayDecibels)
+{
+    //Poles are the roots of z^2 + a1 z + a2
+    auto discriminant = coefficients.a1 * coefficients.a1 - 4.0 * coefficients.a2;
+    auto radius = 0.0;
+
+    if (discriminant < 0.0)
+    {
+        radius = std::sqrt(coefficients.a2);
+    }
+    else
+    {
+        auto root = std::sqrt(discriminant);
+        radius = juce::jmax(std::abs(-coefficients.a1 + root), std::abs(-coefficients.a1 - root)) * 0.5;
+    }
+
+    if (radius <= 0.0)
+        return 2.0; //FIR, done after the two delay elements are flushed
+
+    if (radius >= 1.0)
+        return std::numeric_limits<double>::infinity();
+
+    //Not Decibels::decibelsToGain, that treats anything below -100 dB as silence
+    return std::log(std::pow(10.0, -std::abs(decayDecibels) / 20.0)) / std::log(radius);
+}
+
+//|H(e^jw)|^2 of a biquad as a numerator and a denominator polynomial in phi = 4 sin^2(w/2):
+//
+//  num = (b0 + b1 + b2)^2 - phi (b0 b1 + 4 b0 b2 + b1 b2) + phi^2 b0 b2
+//  den = (1 + a1 + a2)^2  - phi (a1 + 4 a2 + a1 a2)        + phi^2 a2
+//
+//Expanded in cos(w) and cos(2w) instead, the terms are all of order one and cancel down to almost
+//nothing near DC, so poles and zeros close to z = 1 (a low cut at an oversampled rate) come out wrong
+struct BiquadMagnitudeTerms
+{
+    std::array<double, 3> numerator{}, denominator{};
+};
+
+inline BiquadMagnitudeTerms getMagnitudeTerms(const BiquadCoeffs& c)
+{
+    auto b = c.b0 + c.b1 + c.b2;
+    auto a = 1.0 + c.a1 + c.a2;
+
+    return { { b * b, -(c.b0 * c.b1 + 4.0 * c.b0 * c.b2 + c.b1 * c.b2), c.b0 * c.b2 },
+             { a * a, -(c.a1 + 4.0 * c.a2 + c.a1 * c.a2), c.a2 } };
+}
+
+//Works on doubles and on SIMDRegister<double>, several frequencies at once
+template<typename ValueType>
+ValueType evaluateMagnitudeTerm(const std::array<double, 3>& term, ValueType phi)
+{
+    return phi * (phi * term[2] + term[1]) + term[0];
+}
+
+inline double getMagnitudePhi(double omega)
+{
+    auto s = std::sin(omega * 0.5);
+    return 4.0 * s * s;
+}
+
+//==============================================================================
+//Lets the same code run on plain samples (one lane) and on juce::dsp::SIMDRegister (one channel per lane)
+template<typename VectorType>
+struct LaneTraits
+{
+    using ElementType = VectorType;
+    static constexpr size_t numLanes = 1;
+};
+
+template<typename ElementType_>
+struct LaneTraits<juce::dsp::SIMDRegister<ElementType_>>
+{
+    using ElementType = ElementType_;
+    static constexpr size_t numLanes = juce::dsp::SIMDRegister<ElementType>::SIMDNumElements;
+};
+
+//Transposed direct form II, the same structure and operation order as juce::dsp::IIR::Filter
+template<typename VectorType>
+struct BiquadState
+{
+    VectorType z1{}, z2{};
+};
+
+//All stages of a cascade fused into one sample loop, so the block is walked once and the
+//state of every stage stays in registers. NumStages is fixed at compile time so the stage loop unrolls.
+template<int NumStages>
+struct CascadeKernel
+{
+    template<typename VectorType>
+    static void process(const BiquadCoeffs* coefficients, BiquadState<VectorType>* state, VectorType* data, int numSamples)
+    {
+        using ElementType = typename LaneTraits<VectorType>::ElementType;
+
+        ElementType b0[NumStages], b1[NumStages], b2[NumStages], a1[NumStages], a2[NumStages];
+        VectorType z1[NumStages], z2[NumStages];
+
+        for (int stage = 0; stage < NumStages; ++stage)
+        {
+            b0[stage] = static_cast<ElementType>(coefficients[stage].b0);
+            b1[stage] = static_cast<ElementType>(coefficients[stage].b1);
+            b2[stage] = static_cast<ElementType>(coefficients[stage].b2);
+            a1[stage] = static_cast<ElementType>(coefficients[stage].a1);
+            a2[stage] = static_cast<ElementType>(coefficients[stage].a2);
+
+            z1[stage] = state[stage].z1;
+            z2[stage] = state[stage].z2;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto input = data[i];
+
+            for (int stage = 0; stage < NumStages; ++stage)
+            {
+                auto output = input * b0[stage] + z1[stage];
+                z1[stage] = (input * b1[stage]) - (output * a1[stage]) + z2[stage];
+                z2[stage] = (input * b2[stage]) - (output * a2[stage]);
+                input = output;
+            }
+
+            data[i] = input;
+        }
+
+        for (int stage = 0; stage < NumStages; ++stage)
+        {
+            state[stage].z1 = z1[stage];
+            state[stage].z2 = z2[stage];
+        }
+    }
+};
+
+template<typename VectorType>
+using CascadeKernelFunction = void (*)(const BiquadCoeffs*, BiquadState<VectorType>*, VectorType*, int);
+
+//Picks the kernel instantiation for a stage count, only needed when the slope changes
+template<typename VectorType>
+CascadeKernelFunction<VectorType> getCascadeKernel(int numStages)
+{
+    switch (numStages)
+    {
+    case 1: return &CascadeKernel<1>::template process<VectorType>;
+    case 2: return &CascadeKernel<2>::template process<VectorType>;
+    case 3: return &CascadeKernel<3>::template process<VectorType>;
+    case 4: return &CascadeKernel<4>::template process<VectorType>;
+    default: break;
+    }
+
+    jassertfalse;
+    return nullptr;
+}
+
+//==============================================================================
+/*
+ Runs the low cut, peak and high cut bands of a MonoChain over any number of channels.
+ With a SIMDRegister as VectorType the channels are interleaved into the register lanes,
+ so one pass filters as many channels as the register holds.
+ Bypassed bands and stages keep their state untouched, exactly like a bypassed ProcessorChain slot.
+ */
+template<typename VectorType>
+class CascadeChainProcessor
+{
+public:
+    using Traits = LaneTraits<VectorType>;
+    using ElementType = typename Traits::ElementType;
+
+    static constexpr int numBands = 3;
+
+    //Allocates everything, call this off the audio thread
+    void prepare(int numChannels, int maximumBlockSize)
+    {
+        numChannelsPrepared = numChannels;
+
+        auto numGroups = (numChannels + (int)Traits::numLanes - 1) / (int)Traits::numLanes;
+        groupStates.assign((size_t)juce::jmax(1, numGroups), {});
+
+        if constexpr (Traits::numLanes > 1)
+            interleaved.assign((size_t)maximumBlockSize, VectorType{});
+    }
+
+    void reset()
+    {
+        for (auto& group : groupStates)
+            group = {};
+    }
+
+    //A single biquad band, like the peak filter, is a cascade with one stage
+    void setBand(int band, const CutCoeffs& coefficients, bool bypassed)
+    {
+        jassert(juce::isPositiveAndBelow(band, numBands));
+
+        auto& target = bands[(size_t)band];
+        target.coefficients = coefficients;
+        target.bypassed = bypassed;
+
+        if (coefficients.numStages != target.numStages)
+        {
+            target.numStages = coefficients.numStages;
+            target.kernel = getCascadeKernel<VectorType>(target.numStages);
+        }
+    }
+
+    void process(ElementType* const* channels, int numChannels, int numSamples)
+    {
+        jassert(numChannels <= numChannelsPrepared);
+
+        if constexpr (Traits::numLanes == 1)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                processGroup(groupStates[(size_t)channel], channels[channel], numSamples);
+        }
+        else
+        {
+            processInterleaved(channels, numChannels, numSamples);
+        }
+    }
+
+private:
+    void processInterleaved(ElementType* const* channels, int numChannels, int numSamples)
+    {
+        jassert(numSamples <= (int)interleaved.size());
+
+        auto* lanes = reinterpret_cast<ElementType*>(interleaved.data());
+        const auto numLanes = (int)Traits::numLanes;
+
+        for (int firstChannel = 0, group = 0; firstChannel < numChannels; firstChannel += numLanes, ++group)
+        {
+            auto channelsInGroup = juce::jmin(numLanes, numChannels - firstChannel);
+
+            //Spread the channels over the lanes, unused lanes just filter silence
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                if (lane < channelsInGroup)
+                {
+                    const auto* source = channels[firstChannel + lane];
+                    for (int i = 0; i < numSamples; ++i)
+                        lanes[i * numLanes + lane] = source[i];
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        lanes[i * numLanes + lane] = ElementType(0);
+                }
+            }
+
+            processGroup(groupStates[(size_t)group], interleaved.data(), numSamples);
+
+            for (int lane = 0; lane < channelsInGroup; ++lane)
+            {
+                auto* destination = channels[firstChannel + lane];
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] = lanes[i * numLanes + lane];
+            }
+        }
+    }
+
+    struct Band
+    {
+        CutCoeffs coefficients;
+        bool bypassed = false;
+
+        int numStages = 1;
+        CascadeKernelFunction<VectorType> kernel = getCascadeKernel<VectorType>(1);
+    };
+
+    using BandState = std::array<BiquadState<VectorType>, CutCoeffs::maxNumStages>;
+    using GroupState = std::array<BandState, numBands>;
+
+    std::array<Band, numBands> bands;
+    std::vector<GroupState> groupStates;
+    std::vector<VectorType> interleaved;
+    int numChannelsPrepared = 0;
+
+    void processGroup(GroupState& state, VectorType* data, int numSamples)
+    {
+        for (size_t band = 0; band < bands.size(); ++band)
+        {
+            const auto& b = bands[band];
+            if (!b.bypassed)
+                b.kernel(b.coefficients.stages.data(), state[band].data(), data, numSamples);
+        }
+    }
+};
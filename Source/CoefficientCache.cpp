@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    Process-wide cache of designed filter coefficients.
+
+  ==============================================================================
+*/
+
+#include "CoefficientCache.h"
+#include "PluginProcessor.h"
+
+//Step sizes of the parameter ranges in createParameterLayout
+static constexpr double qualityStep = 0.05;
+static constexpr double gainStep = 0.5;
+
+CoefficientCache::CoefficientCache() : entries(numEntries)
+{
+}
+
+size_t CoefficientCache::Key::getHash() const
+{
+	auto hash = (size_t)14695981039346656037ull;
+	auto mix = [&hash](juce::uint64 value)
+	{
+		hash ^= (size_t)value;
+		hash *= (size_t)1099511628211ull;
+	};
+
+	mix((juce::uint64)type);
+	mix((juce::uint64)juce::roundToInt(sampleRate));
+	mix((juce::uint64)frequency);
+	mix((juce::uint64)qualitySteps);
+	mix((juce::uint64)gainSteps);
+	mix((juce::uint64)order);
+
+	return hash ^ (hash >> 29);
+}
+
+template<typename DesignFunction>
+void CoefficientCache::lookup(const Key& key, CutCoeffs& coefficients, DesignFunction&& design)
+{
+	auto index = key.getHash() & (numEntries - 1);
+	auto& lock = locks[index % numLocks];
+	auto& entry = entries[index];
+
+	{
+		const juce::SpinLock::ScopedLockType sl(lock);
+		if (entry.valid && entry.key == key)
+		{
+			coefficients = entry.coefficients;
+			++numHits;
+			return;
+		}
+	}
+
+	//Design outside the lock, the trig is the slow part
+	design(coefficients);
+	++numMisses;
+
+	const juce::SpinLock::ScopedLockType sl(lock);
+	entry.key = key;
+	entry.coefficients = coefficients;
+	entry.valid = true;
+}
+
+void CoefficientCache::getPeakFilter(BiquadCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+	Key key;
+	key.type = FilterType::peak;
+	key.sampleRate = sampleRate;
+	key.frequency = juce::roundToInt(chainSettings.peakFreq);
+	key.qualitySteps = juce::roundToInt(chainSettings.peakQuality / qualityStep);
+	key.gainSteps = juce::roundToInt(chainSettings.peakGainInDecibels / gainStep);
+
+	//Design from the quantised values so the entry is exact for everyone who hits it
+	CutCoeffs peak;
+	lookup(key, peak, [&key](CutCoeffs& c)
+	{
+		c.numStages = 1;
+		c.stages[0] = makePeakBiquad(key.sampleRate,
+									 key.frequency,
+									 key.qualitySteps * qualityStep,
+									 juce::Decibels::decibelsToGain(key.gainSteps * gainStep));
+	});
+
+	coefficients = peak.stages[0];
+}
+
+void CoefficientCache::getLowCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+	Key key;
+	key.type = FilterType::lowCut;
+	key.sampleRate = sampleRate;
+	key.frequency = juce::roundToInt(chainSettings.lowCutFreq);
+	key.order = 2 * (chainSettings.lowCutSlope + 1);
+
+	lookup(key, coefficients, [&key, &chainSettings](CutCoeffs& c)
+	{
+		designButterworthHighPass(c, key.frequency, key.sampleRate, chainSettings.lowCutSlope);
+	});
+}
+
+void CoefficientCache::getHighCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+	Key key;
+	key.type = FilterType::highCut;
+	key.sampleRate = sampleRate;
+	key.frequency = juce::roundToInt(chainSettings.highCutFreq);
+	key.order = 2 * (chainSettings.highCutSlope + 1);
+
+	lookup(key, coefficients, [&key, &chainSettings](CutCoeffs& c)
+	{
+		designButterworthLowPass(c, key.frequency, key.sampleRate, chainSettings.highCutSlope);
+	});
+}
@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    Process-wide cache of designed filter coefficients.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+
+struct ChainSettings;
+
+/*
+ Every processor and response curve in the process shares one of these through
+ juce::SharedResourcePointer, so identical bands are only designed once.
+ The parameters are already quantised by their ranges (1 Hz, 0.5 dB, 0.05 Q), which makes
+ them usable as keys directly. The table has a fixed size and a colliding entry simply
+ replaces the old one, so it never grows and never allocates after construction.
+ Safe to use from any number of threads, but it locks, so keep it off the realtime audio thread.
+ */
+class CoefficientCache
+{
+public:
+    CoefficientCache();
+
+    void getPeakFilter(BiquadCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+    void getLowCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+    void getHighCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+
+    juce::int64 getNumHits() const { return numHits.load(); }
+    juce::int64 getNumMisses() const { return numMisses.load(); }
+
+private:
+    enum class FilterType
+    {
+        lowCut,
+        peak,
+        highCut
+    };
+
+    struct Key
+    {
+        FilterType type{ FilterType::peak };
+        double sampleRate{ 0.0 };
+        int frequency{ 0 }, qualitySteps{ 0 }, gainSteps{ 0 }, order{ 0 };
+
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && sampleRate == other.sampleRate && frequency == other.frequency
+                && qualitySteps == other.qualitySteps && gainSteps == other.gainSteps && order == other.order;
+        }
+
+        size_t getHash() const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        bool valid{ false };
+        CutCoeffs coefficients;
+    };
+
+    static constexpr size_t numEntries = 2048;
+    static constexpr size_t numLocks = 64;
+
+    std::vector<Entry> entries;
+    std::array<juce::SpinLock, numLocks> locks;
+    std::atomic<juce::int64> numHits{ 0 }, numMisses{ 0 };
+
+    template<typename DesignFunction>
+    void lookup(const Key& key, CutCoeffs& coefficients, DesignFunction&& design);
+
+    JUCE_DECLARE_NON_COPYABLE(CoefficientCache)
+};
@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    Linear phase kernel design and partitioned convolution.
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseConvolver.h"
+
+static int getOrder(int size)
+{
+	jassert(juce::isPowerOfTwo(size));
+	return juce::roundToInt(std::log2((double)size));
+}
+
+//==============================================================================
+void LinearPhaseKernelDesigner::prepare(int maxLength, int newPartitionSize)
+{
+	partitionSize = newPartitionSize;
+
+	//Every power of two length from one partition up
+	auto maxOrder = getOrder(maxLength);
+	kernelFFTs.clear();
+	kernelFFTs.resize((size_t)maxOrder + 1);
+
+	for (auto order = getOrder(partitionSize); order <= maxOrder; ++order)
+		kernelFFTs[(size_t)order] = std::make_unique<juce::dsp::FFT>(order);
+
+	partitionFFT = std::make_unique<juce::dsp::FFT>(getOrder(2 * partitionSize));
+
+	spectrum.assign((size_t)(2 * maxLength), 0.f);
+	window.assign((size_t)maxLength + 1, 0.f);
+	partitionBuffer.assign((size_t)(4 * partitionSize), 0.f);
+}
+
+void LinearPhaseKernelDesigner::design(LinearPhaseKernel& kernel,
+									   const BiquadCoeffs* sections,
+									   int numSections,
+									   double hostSampleRate,
+									   double filterSampleRate,
+									   int length)
+{
+	jassert(length % partitionSize == 0 && length * 2 <= (int)spectrum.size());
+	auto& fft = *kernelFFTs[(size_t)getOrder(length)];
+
+	//Same well conditioned polynomials as the response curve, low cuts at oversampled rates sit right next to DC
+	std::array<BiquadMagnitudeTerms, maxNumSections> terms;
+	jassert(numSections <= maxNumSections);
+	numSections = juce::jmin(numSections, maxNumSections);
+
+	for (int s = 0; s < numSections; ++s)
+		terms[(size_t)s] = getMagnitudeTerms(sections[s]);
+
+	//Zero phase spectrum: |H| of the whole cascade on every bin. The bins are spaced at the host rate,
+	//the sections were designed at the (possibly oversampled) filter rate
+	for (int bin = 0; bin <= length / 2; ++bin)
+	{
+		auto frequency = bin * hostSampleRate / length;
+		auto phi = getMagnitudePhi(juce::MathConstants<double>::twoPi * frequency / filterSampleRate);
+
+		auto magnitudeSquared = 1.0;
+		for (int s = 0; s < numSections; ++s)
+		{
+			const auto& t = terms[(size_t)s];
+			magnitudeSquared *= juce::jmax(0.0, evaluateMagnitudeTerm(t.numerator, phi)) / evaluateMagnitudeTerm(t.denominator, phi);
+		}
+
+		spectrum[(size_t)(2 * bin)] = (float)std::sqrt(magnitudeSquared);
+		spectrum[(size_t)(2 * bin + 1)] = 0.f;
+	}
+
+	fft.performRealOnlyInverseTransform(spectrum.data());
+
+	//The impulse comes out centred on sample 0, move it to the middle and window off the truncation.
+	//A symmetric window of length + 1 keeps the taps symmetric around length / 2
+	juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t)length + 1,
+															 juce::dsp::WindowingFunction<float>::blackman, false);
+
+	auto* taps = spectrum.data() + length;
+	for (int i = 0; i < length; ++i)
+		taps[i] = spectrum[(size_t)((i + length / 2) % length)] * window[(size_t)i];
+
+	kernel.length = length;
+	kernel.numPartitions = length / partitionSize;
+
+	const auto numBins = partitionSize + 1;
+	jassert((int)kernel.partitions.size() >= kernel.numPartitions * numBins);
+
+	for (int partition = 0; partition < kernel.numPartitions; ++partition)
+	{
+		std::fill(partitionBuffer.begin(), partitionBuffer.end(), 0.f);
+		std::copy(taps + partition * partitionSize, taps + (partition + 1) * partitionSize, partitionBuffer.begin());
+
+		partitionFFT->performRealOnlyForwardTransform(partitionBuffer.data(), true);
+
+		const auto* bins = reinterpret_cast<const std::complex<float>*>(partitionBuffer.data());
+		std::copy(bins, bins + numBins, kernel.partitions.begin() + partition * numBins);
+	}
+}
+
+//==============================================================================
+void PartitionedConvolver::prepare(int newPartitionSize, int newMaxNumPartitions)
+{
+	partitionSize = newPartitionSize;
+	numBins = partitionSize + 1;
+	maxNumPartitions = newMaxNumPartitions;
+
+	fft = std::make_unique<juce::dsp::FFT>(getOrder(2 * partitionSize));
+
+	inputBlock.assign((size_t)partitionSize, 0.f);
+	previousBlock.assign((size_t)partitionSize, 0.f);
+	outputBlock.assign((size_t)partitionSize, 0.f);
+	fadeBlock.assign((size_t)partitionSize, 0.f);
+	fftBuffer.assign((size_t)(4 * partitionSize), 0.f);
+
+	delayLine.assign((size_t)(maxNumPartitions * numBins), {});
+	accumulator.assign((size_t)numBins, {});
+
+	reset();
+}
+
+void PartitionedConvolver::reset()
+{
+	std::fill(inputBlock.begin(), inputBlock.end(), 0.f);
+	std::fill(previousBlock.begin(), previousBlock.end(), 0.f);
+	std::fill(outputBlock.begin(), outputBlock.end(), 0.f);
+	std::fill(delayLine.begin(), delayLine.end(), std::complex<float>{});
+	delayLinePosition = 0;
+}
+
+void PartitionedConvolver::processPartition(const LinearPhaseKernel& kernel, const LinearPhaseKernel* fadeFrom, const float* fadeIn)
+{
+	//Overlap-save: transform the last two blocks, only the second half of the result is free of wrap around
+	auto* buffer = fftBuffer.data();
+	std::copy(previousBlock.begin(), previousBlock.end(), buffer);
+	std::copy(inputBlock.begin(), inputBlock.end(), buffer + partitionSize);
+	std::fill(buffer + 2 * partitionSize, buffer + 4 * partitionSize, 0.f);
+
+	fft->performRealOnlyForwardTransform(buffer, true);
+
+	const auto* bins = reinterpret_cast<const std::complex<float>*>(buffer);
+	std::copy(bins, bins + numBins, delayLine.begin() + delayLinePosition * numBins);
+
+	std::swap(previousBlock, inputBlock);
+
+	convolve(kernel, outputBlock.data());
+
+	if (fadeFrom != nullptr)
+	{
+		convolve(*fadeFrom, fadeBlock.data());
+
+		for (int i = 0; i < partitionSize; ++i)
+			outputBlock[(size_t)i] = fadeBlock[(size_t)i] + (outputBlock[(size_t)i] - fadeBlock[(size_t)i]) * fadeIn[i];
+	}
+
+	delayLinePosition = (delayLinePosition + 1) % maxNumPartitions;
+}
+
+void PartitionedConvolver::convolve(const LinearPhaseKernel& kernel, float* destination)
+{
+	jassert(kernel.numPartitions <= maxNumPartitions);
+	std::fill(accumulator.begin(), accumulator.end(), std::complex<float>{});
+
+	//Spelled out instead of std::complex's operator*, which has to care about inf and NaN and doesn't vectorise
+	auto* sum = reinterpret_cast<float*>(accumulator.data());
+
+	for (int partition = 0; partition < kernel.numPartitions; ++partition)
+	{
+		//The newest input block meets the first partition of the kernel, older ones the later partitions
+		auto slot = (delayLinePosition - partition + maxNumPartitions) % maxNumPartitions;
+		const auto* x = reinterpret_cast<const float*>(delayLine.data() + slot * numBins);
+		const auto* h = reinterpret_cast<const float*>(kernel.partitions.data() + partition * numBins);
+
+		for (int bin = 0; bin < 2 * numBins; bin += 2)
+		{
+			sum[bin] += x[bin] * h[bin] - x[bin + 1] * h[bin + 1];
+			sum[bin + 1] += x[bin] * h[bin + 1] + x[bin + 1] * h[bin];
+		}
+	}
+
+	auto* buffer = fftBuffer.data();
+	std::copy(sum, sum + 2 * numBins, buffer);
+	fft->performRealOnlyInverseTransform(buffer);
+
+	std::copy(buffer + partitionSize, buffer + 2 * partitionSize, destination);
+}
+
+//==============================================================================
+void LinearPhaseEqualizer::prepare(int numChannels)
+{
+	constexpr auto maxNumPartitions = maxKernelLength / partitionSize;
+
+	designer.prepare(maxKernelLength, partitionSize);
+
+	for (auto& slot : slots)
+	{
+		slot.partitions.assign((size_t)(maxNumPartitions * (partitionSize + 1)), {});
+		slot.length = 0;
+		slot.numPartitions = 0;
+	}
+
+	slotState.store(packSlots(noSlot, noSlot, noSlot, 0, 0));
+	currentSlot = -1;
+	fadingSlot = -1;
+
+	while (convolvers.size() < numChannels)
+		convolvers.add(new PartitionedConvolver());
+
+	for (auto* convolver : convolvers)
+		convolver->prepare(partitionSize, maxNumPartitions);
+
+	//Raised cosine over one partition, old and new kernel see the same input so their outputs add up coherently
+	fadeIn.resize((size_t)partitionSize);
+	for (int i = 0; i < partitionSize; ++i)
+		fadeIn[(size_t)i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (i + 0.5f) / partitionSize);
+
+	partitionPosition = 0;
+}
+
+void LinearPhaseEqualizer::reset()
+{
+	for (auto* convolver : convolvers)
+		convolver->reset();
+
+	partitionPosition = 0;
+
+	//Nothing left to fade from
+	if (fadingSlot >= 0)
+	{
+		fadingSlot = -1;
+		storeSlots();
+	}
+}
+
+bool LinearPhaseEqualizer::designKernel(const BiquadCoeffs* sections, int numSections, double hostSampleRate, double filterSampleRate, int length)
+{
+	jassert(length <= maxKernelLength);
+	auto state = slotState.load(std::memory_order_acquire);
+	auto releases = getReleases(state);
+
+	//The audio thread only ever moves slots between playing, fading and pending,
+	//so a slot that is none of those stays ours while we write it
+	auto freeSlot = -1;
+	for (int slot = 0; slot < numSlots && freeSlot < 0; ++slot)
+		if (slot != getCurrent(state) && slot != getFading(state) && slot != getPending(state))
+			freeSlot = slot;
+
+	if (freeSlot < 0)
+		return false;
+
+	designer.design(slots[(size_t)freeSlot], sections, numSections, hostSampleRate, filterSampleRate, length);
+
+	//Replaces a pending kernel the audio thread hasn't picked up yet, that one is free again
+	for (;;)
+	{
+		//Released while we were designing: these settings are stale and the processor asks for a fresh kernel anyway
+		if (getReleases(state) != releases)
+			return true;
+
+		if (slotState.compare_exchange_weak(state, packSlots(getCurrent(state), getFading(state), freeSlot, getOrder(length), releases), std::memory_order_acq_rel))
+			return true;
+	}
+}
+
+bool LinearPhaseEqualizer::updateKernel()
+{
+	//Let the running crossfade finish first
+	if (fadingSlot >= 0)
+		return false;
+
+	auto state = slotState.load(std::memory_order_acquire);
+
+	for (;;)
+	{
+		auto pending = toSlot(getPending(state));
+		if (pending < 0)
+			return false;
+
+		//The pending slot may still be rewritten until the exchange below succeeds, its length comes from the state
+		auto sameLength = currentSlot >= 0 && (1 << getPendingOrder(state)) == slots[(size_t)currentSlot].length;
+		auto fading = sameLength ? currentSlot : -1;
+
+		if (slotState.compare_exchange_weak(state, packSlots(pending, fromSlot(fading), noSlot, 0, getReleases(state)), std::memory_order_acq_rel))
+		{
+			currentSlot = pending;
+			fadingSlot = fading;
+
+			//The delay line was built for the old length's latency, start over
+			if (!sameLength)
+			{
+				for (auto* convolver : convolvers)
+					convolver->reset();
+
+				partitionPosition = 0;
+			}
+
+			return !sameLength;
+		}
+	}
+}
+
+void LinearPhaseEqualizer::releaseKernel()
+{
+	currentSlot = -1;
+	fadingSlot = -1;
+
+	//A pending kernel was designed for the settings we're walking away from
+	auto state = slotState.load(std::memory_order_relaxed);
+	while (!slotState.compare_exchange_weak(state, packSlots(noSlot, noSlot, noSlot, 0, getReleases(state) + 1), std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+
+	for (auto* convolver : convolvers)
+		convolver->reset();
+
+	partitionPosition = 0;
+}
+
+void LinearPhaseEqualizer::storeSlots()
+{
+	auto state = slotState.load(std::memory_order_relaxed);
+
+	while (!slotState.compare_exchange_weak(state, packSlots(fromSlot(currentSlot), fromSlot(fadingSlot), getPending(state), getPendingOrder(state), getReleases(state)), std::memory_order_release, std::memory_order_relaxed))
+	{
+	}
+}
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    Linear phase version of the filter chain: an FIR kernel with the same
+    magnitude response as the biquads, run through a partitioned convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+#include "BiquadCascade.h"
+
+//==============================================================================
+//One kernel, already cut into partitions and transformed, ready for the convolver
+struct LinearPhaseKernel
+{
+    int length{ 0 };        //taps, the kernel is centred on length / 2
+    int numPartitions{ 0 };
+
+    //numPartitions blocks of partitionSize + 1 bins, the spectrum of each zero padded partition
+    std::vector<std::complex<float>> partitions;
+};
+
+/*
+ Turns the magnitude of a cascade of biquads into a symmetric FIR kernel:
+ |H| is sampled on the FFT grid, the zero phase spectrum is transformed back,
+ centred and windowed. Only prepare() allocates.
+ */
+class LinearPhaseKernelDesigner
+{
+public:
+    //Every cut filter stage plus the peak
+    static constexpr int maxNumSections = 2 * CutCoeffs::maxNumStages + 1;
+
+    void prepare(int maxLength, int partitionSize);
+
+    //'hostSampleRate' is the rate the kernel runs at, 'filterSampleRate' the one the sections were designed for
+    void design(LinearPhaseKernel& kernel,
+                const BiquadCoeffs* sections,
+                int numSections,
+                double hostSampleRate,
+                double filterSampleRate,
+                int length);
+
+private:
+    std::vector<std::unique_ptr<juce::dsp::FFT>> kernelFFTs; //indexed by order
+    std::unique_ptr<juce::dsp::FFT> partitionFFT;
+    std::vector<float> spectrum, window, partitionBuffer;
+    int partitionSize = 0;
+};
+
+/*
+ Uniformly partitioned overlap-save convolution for one channel.
+ The input is gathered in blocks of partitionSize. Each block is transformed once into a
+ frequency domain delay line, and every output block is the sum of that delay line times the
+ kernel partitions, so a long kernel costs one multiply-add per bin and partition instead of
+ one per tap. The price is one partition of latency on top of the kernel's own.
+
+ Everything in here is float, because juce::dsp::FFT only comes in float. Double precision
+ input is rounded to float on the way in and widened again on the way out, so in linear
+ phase mode a double precision host gets float accuracy.
+ */
+class PartitionedConvolver
+{
+public:
+    void prepare(int partitionSize, int maxNumPartitions);
+    void reset();
+
+    //Swaps 'numSamples' samples of input for the same amount of output, starting at 'offset' into the current partition
+    template<typename SampleType>
+    void exchange(SampleType* data, int offset, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto output = outputBlock[(size_t)(offset + i)];
+            inputBlock[(size_t)(offset + i)] = (float)data[i];
+            data[i] = (SampleType)output;
+        }
+    }
+
+    //Called once a whole partition of input is in. With 'fadeFrom' set the next output block
+    //moves from that kernel to 'kernel' along 'fadeIn'
+    void processPartition(const LinearPhaseKernel& kernel, const LinearPhaseKernel* fadeFrom, const float* fadeIn);
+
+private:
+    void convolve(const LinearPhaseKernel& kernel, float* destination);
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    int partitionSize = 0, numBins = 0, maxNumPartitions = 0;
+
+    std::vector<float> inputBlock, previousBlock, outputBlock, fadeBlock, fftBuffer;
+    std::vector<std::complex<float>> delayLine, accumulator;
+    int delayLinePosition = 0;
+};
+
+//==============================================================================
+/*
+ The linear phase engine of the processor: kernels come from the design thread, the audio thread
+ convolves with them.
+
+ Kernels live in three slots: the one playing, the one being faded out and one for the designer
+ to write into. Which slot is which sits in a single atomic, so the designer never writes a kernel
+ the audio thread can still see. A new kernel of the same length is crossfaded in over one
+ partition; a new length changes the latency, so it starts from a cleared state instead.
+ */
+class LinearPhaseEqualizer
+{
+public:
+    static constexpr int partitionSize = 256;
+    static constexpr int maxKernelLength = 16384;
+
+    //Allocates everything. Neither the audio thread nor the designer may be running
+    void prepare(int numChannels);
+    void reset();
+
+    //Design thread. Returns false when both spare slots are still in use, try again on the next pass
+    bool designKernel(const BiquadCoeffs* sections, int numSections, double hostSampleRate, double filterSampleRate, int length);
+
+    //Audio thread, once per block. Picks up a new kernel once the last crossfade finished,
+    //returns true if that changed the latency
+    bool updateKernel();
+
+    //Audio thread. Stops using the current kernel and drops a pending one, the next one has to be designed from scratch.
+    //A kernel the designer is working on right now is thrown away when it's done
+    void releaseKernel();
+
+    bool hasKernel() const { return currentSlot >= 0; }
+    int getKernelLength() const { return hasKernel() ? slots[(size_t)currentSlot].length : 0; }
+
+    //Half the kernel plus the partition the input is gathered in
+    int getLatencySamples() const { return hasKernel() ? getKernelLength() / 2 + partitionSize : 0; }
+    int getTailSamples() const { return hasKernel() ? getKernelLength() + partitionSize : 0; }
+
+    //Float or double, either way the convolution itself runs in float (see PartitionedConvolver)
+    template<typename SampleType>
+    void process(SampleType* const* channels, int numChannels, int numSamples)
+    {
+        jassert(hasKernel());
+        jassert(numChannels <= convolvers.size());
+
+        for (int done = 0; done < numSamples;)
+        {
+            auto numToExchange = juce::jmin(numSamples - done, partitionSize - partitionPosition);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                convolvers.getUnchecked(channel)->exchange(channels[channel] + done, partitionPosition, numToExchange);
+
+            partitionPosition += numToExchange;
+            done += numToExchange;
+
+            if (partitionPosition == partitionSize)
+            {
+                const auto* fadeFrom = fadingSlot >= 0 ? &slots[(size_t)fadingSlot] : nullptr;
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    convolvers.getUnchecked(channel)->processPartition(slots[(size_t)currentSlot], fadeFrom, fadeIn.data());
+
+                partitionPosition = 0;
+
+                if (fadingSlot >= 0)
+                {
+                    fadingSlot = -1;
+                    storeSlots();
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr int numSlots = 3;
+    static constexpr int noSlot = 3;
+
+    //current | fading << 2 | pending << 4 | log2 of the pending length << 6 | releases << 10, noSlot where there isn't one.
+    //The pending length travels with the slot index, the audio thread can't look at a slot before it owns it.
+    //'releases' counts releaseKernel() calls, so the designer can tell its kernel is no longer wanted
+    static int packSlots(int current, int fading, int pending, int pendingOrder, int releases)
+    {
+        return current | (fading << 2) | (pending << 4) | (pendingOrder << 6) | ((releases & 0xffff) << 10);
+    }
+
+    static int getCurrent(int packed) { return packed & 3; }
+    static int getFading(int packed) { return (packed >> 2) & 3; }
+    static int getPending(int packed) { return (packed >> 4) & 3; }
+    static int getPendingOrder(int packed) { return (packed >> 6) & 15; }
+    static int getReleases(int packed) { return packed >> 10; }
+
+    static int toSlot(int index) { return index == noSlot ? -1 : index; }
+    static int fromSlot(int slot) { return slot < 0 ? noSlot : slot; }
+
+    //Publishes the audio thread's current and fading slots, keeping whatever is pending
+    void storeSlots();
+
+    std::array<LinearPhaseKernel, numSlots> slots;
+    std::atomic<int> slotState{ packSlots(noSlot, noSlot, noSlot, 0, 0) };
+
+    //Audio thread copies of the packed state
+    int currentSlot = -1, fadingSlot = -1;
+    int partitionPosition = 0;
+
+    LinearPhaseKernelDesigner designer;
+    juce::OwnedArray<PartitionedConvolver> convolvers;
+    std::vector<float> fadeIn;
+};
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    Evaluates the magnitude response of a list of biquads over a whole frequency grid.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+
+/*
+ For a biquad, |H(e^jw)|^2 only depends on phi = 4 sin^2(w/2) (see BiquadMagnitudeTerms),
+ so the trig is done once per point when the grid changes, and evaluating a chain is a few
+ multiply-adds per section per point, several points per SIMD register.
+ Numerators and denominators are multiplied up separately, so there's one division and one
+ log per point however many sections there are.
+ */
+class MagnitudeResponseEvaluator
+{
+public:
+    using Vector = juce::dsp::SIMDRegister<double>;
+    static constexpr size_t numLanes = Vector::SIMDNumElements;
+
+    //Log spaced points from minFrequency to maxFrequency, like the response curve's x axis.
+    //Only does any work when the grid actually changed
+    void prepare(int numPoints, double sampleRate, double minFrequency = 20.0, double maxFrequency = 20000.0)
+    {
+        jassert(sampleRate > 0.0);
+
+        if (numPoints == preparedNumPoints && sampleRate == preparedSampleRate
+            && minFrequency == preparedMinFrequency && maxFrequency == preparedMaxFrequency)
+            return;
+
+        preparedNumPoints = numPoints;
+        preparedSampleRate = sampleRate;
+        preparedMinFrequency = minFrequency;
+        preparedMaxFrequency = maxFrequency;
+
+        auto numVectors = ((size_t)juce::jmax(0, numPoints) + numLanes - 1) / numLanes;
+        phis.resize(numVectors);
+        decibels.resize(numVectors * numLanes);
+
+        for (size_t v = 0; v < numVectors; ++v)
+        {
+            alignas(Vector::SIMDRegisterSize) double phi[numLanes];
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                //Padding lanes past the last point are evaluated too, at DC, and then ignored
+                auto point = (int)(v * numLanes + lane);
+                auto omega = 0.0;
+
+                if (point < numPoints)
+                {
+                    auto frequency = juce::mapToLog10((double)point / (double)numPoints, minFrequency, maxFrequency);
+                    omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+                }
+
+                phi[lane] = getMagnitudePhi(omega);
+            }
+
+            phis[v] = Vector::fromRawArray(phi);
+        }
+    }
+
+    //Magnitude of the product of all sections in decibels, one value per point (floored at -100 dB like Decibels::gainToDecibels)
+    const double* process(const BiquadCoeffs* sections, int numSections)
+    {
+        jassert(numSections <= maxNumSections);
+        numSections = juce::jmin(numSections, maxNumSections);
+
+        //The squared magnitude polynomials of every section, ready to broadcast
+        std::array<BiquadMagnitudeTerms, maxNumSections> terms;
+
+        for (int s = 0; s < numSections; ++s)
+            terms[(size_t)s] = getMagnitudeTerms(sections[s]);
+
+        for (size_t v = 0; v < phis.size(); ++v)
+        {
+            const auto phi = phis[v];
+
+            auto numerator = Vector::expand(1.0);
+            auto denominator = Vector::expand(1.0);
+
+            for (int s = 0; s < numSections; ++s)
+            {
+                const auto& t = terms[(size_t)s];
+                numerator = numerator * evaluateMagnitudeTerm(t.numerator, phi);
+                denominator = denominator * evaluateMagnitudeTerm(t.denominator, phi);
+            }
+
+            alignas(Vector::SIMDRegisterSize) double n[numLanes], d[numLanes];
+            numerator.copyToRawArray(n);
+            denominator.copyToRawArray(d);
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                decibels[v * numLanes + lane] = juce::jmax(-100.0, 10.0 * std::log10(n[lane] / d[lane]));
+        }
+
+        return decibels.data();
+    }
+
+    //Every cut filter stage plus the peak
+    static constexpr int maxNumSections = 2 * CutCoeffs::maxNumStages + 1;
+
+private:
+    std::vector<Vector> phis;
+    std::vector<double> decibels;
+
+    int preparedNumPoints = -1;
+    double preparedSampleRate = 0.0, preparedMinFrequency = 0.0, preparedMaxFrequency = 0.0;
+};
@@ -236,10 +236,9 @@ juce::String RotarySliderWithLabels::getDisplayString() const
 }
 
 //==============================================================================
-ResponseCurveComponent::ResponseCurveComponent(AudioPlugin_TestAudioProcessor& p) :	audioProcessor(p),	leftPathProducer(audioProcessor.leftChannelFifo),
-	rightPathProducer(audioProcessor.rightChannelFifo)
+ResponseCurveComponent::ResponseCurveComponent(AudioPlugin_TestAudioProcessor& p) :	audioProcessor(p),	pathProducer(audioProcessor.leftChannelFifo, audioProcessor.rightChannelFifo)
 {
-	//Updated as listener 
+	//Updated as listener
 	const auto& params = audioProcessor.getParameters();
 	for (auto param : params)
 	{
@@ -248,11 +247,22 @@ ResponseCurveComponent::ResponseCurveComponent(AudioPlugin_TestAudioProcessor& p
 
 	updateChain();
 
-	startTimerHz(60);
+	//The button attachment doesn't call onClick, so pick up the saved state here
+	toggleAnalysisEnablement(audioProcessor.apvts.getRawParameterValue("Analyzer Enabled")->load() > 0.5f);
+
+	analysisThread->addTimeSliceClient(&pathProducer);
+	audioProcessor.addAnalyzerConsumer();
+
+	startTimerHz(frameRate);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+	audioProcessor.removeAnalyzerConsumer();
+
+	//Waits for a slice that's still running on the analysis thread
+	analysisThread->removeTimeSliceClient(&pathProducer);
+
 	const auto& params = audioProcessor.getParameters();
 	for (auto param : params)
 	{
@@ -266,52 +276,31 @@ void ResponseCurveComponent::updateResponseCurve()
 	auto responseArea = getAnalysisArea();
 
 	auto w = responseArea.getWidth();
+	if (w <= 0)
+		return;
 
-	auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-	auto& peak = monoChain.get<ChainPositions::Peak>();
-	auto& highcut = monoChain.get<ChainPositions::HighCut>();
-
-	auto sampleRate = audioProcessor.getSampleRate();
-
-	std::vector<double> mags;
-
-	mags.resize(w);
-
-	// All the background lines in response curve
-	for (int i = 0; i < w; ++i)
+	//A new grid invalidates every band's curve.
+	//Before the processor is prepared there are no sections and the curve is flat, so any rate does for the grid
+	auto sampleRate = getFilterSampleRate();
+	if (w != curveWidth || sampleRate != curveSampleRate)
 	{
-		double mag = 1.f;
-		auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+		curveWidth = w;
+		curveSampleRate = sampleRate;
+		responseEvaluator.prepare(w, sampleRate > 0.0 ? sampleRate : 44100.0);
+		responseDecibels.resize((size_t)w);
+		bandCurveDirty.fill(true);
+	}
 
-		if (!monoChain.isBypassed<ChainPositions::Peak>())
-			mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+	for (int band = 0; band < numChainPositions; ++band)
+		if (bandCurveDirty[(size_t)band])
+			updateBandCurve(band);
 
-		if (!monoChain.isBypassed<ChainPositions::LowCut>())
-		{
-			if (!lowcut.isBypassed<0>())
-				mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<1>())
-				mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<2>())
-				mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<3>())
-				mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		}
+	//Magnitudes multiply, so the decibels of the bands just add up
+	FloatVectorOperations::copy(responseDecibels.data(), bandCurves[0].data(), w);
+	for (size_t band = 1; band < bandCurves.size(); ++band)
+		FloatVectorOperations::add(responseDecibels.data(), bandCurves[band].data(), w);
 
-		if (!monoChain.isBypassed<ChainPositions::HighCut>())
-		{
-			if (!highcut.isBypassed<0>())
-				mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<1>())
-				mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<2>())
-				mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<3>())
-				mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		}
-
-		mags[i] = Decibels::gainToDecibels(mag);
-	}
+	const auto& mags = responseDecibels;
 
 	responseCurve.clear();
 
@@ -330,35 +319,121 @@ void ResponseCurveComponent::updateResponseCurve()
 	}
 }
 
+void ResponseCurveComponent::updateBandCurve(int band)
+{
+	auto& curve = bandCurves[(size_t)band];
+	curve.resize((size_t)curveWidth);
+	bandCurveDirty[(size_t)band] = false;
+
+	std::array<BiquadCoeffs, CutCoeffs::maxNumStages> sections;
+	int numSections = 0;
+
+	auto addCut = [&sections, &numSections](const CutCoeffs& coefficients)
+	{
+		for (int stage = 0; stage < coefficients.numStages; ++stage)
+			sections[(size_t)numSections++] = coefficients.stages[(size_t)stage];
+	};
+
+	switch (band)
+	{
+	case ChainPositions::LowCut:
+		if (!chainSettings.lowCutBypassed)
+			addCut(lowCutCoefficients);
+		break;
+	case ChainPositions::Peak:
+		if (!chainSettings.peakBypassed)
+			sections[(size_t)numSections++] = peakCoefficients;
+		break;
+	case ChainPositions::HighCut:
+		if (!chainSettings.highCutBypassed)
+			addCut(highCutCoefficients);
+		break;
+	default:
+		break;
+	}
+
+	//Bypassed, or nothing designed yet: flat
+	if (numSections == 0 || curveSampleRate <= 0.0)
+	{
+		juce::FloatVectorOperations::clear(curve.data(), curveWidth);
+		return;
+	}
+
+	juce::FloatVectorOperations::copy(curve.data(), responseEvaluator.process(sections.data(), numSections), curveWidth);
+}
+
 void ResponseCurveComponent::paint(juce::Graphics& g)
 {
 	using namespace juce;
-	// (Our component is opaque, so we must completely fill the background with a solid colour)
-	g.fillAll(Colours::black);
+	auto paintStart = Time::getMillisecondCounterHiRes();
+	framesWaitingForPaint = 0;
 
-	//Background image in response curve 
-	drawBackgroundGrid(g);
+	//The layers are drawn at the physical resolution, so they stay sharp on high DPI displays
+	auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+	if (scale != layerScale || !backgroundLayer.isValid())
+		updateStaticLayers(scale);
 
-	auto responseArea = getAnalysisArea();
+	const auto toComponent = AffineTransform::scale(1.f / layerScale);
+
+	//Background image in response curve, opaque so it covers everything
+	g.drawImageTransformed(backgroundLayer, toComponent);
 
 	if (shouldShowFFTAnalysis)
 	{
-		auto leftChannelFFTPath = leftPathProducer.getPath();
-		leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));//Translate our path to analysis bounding box origin
+		//Already in our coordinates, drawn straight out of the read slot
+		const auto& analyzerPaths = pathProducer.getPaths();
 
+		//Left, or mid
 		g.setColour(Colour(97u, 18u, 167u)); //purple-
-		g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));//Path is drawn at 0,0
-
-		auto rightChannelFFTPath = rightPathProducer.getPath();
-		rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+		g.strokePath(analyzerPaths.channels[0], PathStrokeType(1.f));
 
+		//Right, or side
 		g.setColour(Colour(215u, 201u, 134u));
-		g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+		g.strokePath(analyzerPaths.channels[1], PathStrokeType(1.f));
 	}
 
 	g.setColour(Colours::white);
 	g.strokePath(responseCurve, PathStrokeType(2.f));
 
+	//Border, labels and frame
+	g.drawImageTransformed(foregroundLayer, toComponent);
+
+	lastPaintMs = Time::getMillisecondCounterHiRes() - paintStart;
+}
+
+void ResponseCurveComponent::updateStaticLayers(float scale)
+{
+	using namespace juce;
+	layerScale = scale;
+
+	auto width = jmax(1, roundToInt(getWidth() * scale));
+	auto height = jmax(1, roundToInt(getHeight() * scale));
+
+	// (Our component is opaque, so the background layer completely fills it with a solid colour)
+	backgroundLayer = Image(Image::RGB, width, height, false);
+	{
+		Graphics g(backgroundLayer);
+		g.addTransform(AffineTransform::scale(scale));
+		g.fillAll(Colours::black);
+		drawBackgroundGrid(g);
+	}
+
+	foregroundLayer = Image(Image::ARGB, width, height, true);
+	{
+		Graphics g(foregroundLayer);
+		g.addTransform(AffineTransform::scale(scale));
+		drawBorder(g);
+		drawTextLabels(g);
+
+		g.setColour(Colours::orange);
+		g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
+	}
+}
+
+//Blacks out everything around the rounded render area
+void ResponseCurveComponent::drawBorder(juce::Graphics& g)
+{
+	using namespace juce;
 	Path border;
 
 	border.setUsingNonZeroWinding(false);
@@ -369,11 +444,6 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 	g.setColour(Colours::black);
 
 	g.fillPath(border);
-
-	drawTextLabels(g);
-
-	g.setColour(Colours::orange);
-	g.drawRoundedRectangle(getRenderArea().toFloat(), 4.f, 1.f);
 }
 
 // All the frequencies in the background image 
@@ -530,109 +600,253 @@ void ResponseCurveComponent::resized()
 
 	responseCurve.preallocateSpace(getWidth() * 3);
 	updateResponseCurve();
+
+	//Redrawn at the next paint
+	backgroundLayer = {};
+	foregroundLayer = {};
 }
 
 //Whenever parameter set this value 
 void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
 {
-	parametersChanged.set(true);
+	//Only the band this parameter belongs to needs a new curve, the analyzer settings don't touch it
+	auto position = audioProcessor.getChainPositionForParameterIndex(parameterIndex);
+	if (position >= 0)
+		bandVersions[(size_t)position].fetch_add(1, std::memory_order_release);
 }
 
-//
+//Only repaints when the analyzer delivered new paths or the curve changed
 void ResponseCurveComponent::timerCallback()
 {
-	if (shouldShowFFTAnalysis)
+	auto showing = isShowing();
+	auto needsRepaint = false;
+
+	//No point analysing what nobody can see
+	pathProducer.setActive(shouldShowFFTAnalysis && showing);
+
+	if (shouldShowFFTAnalysis && showing)
 	{
 		auto fftBounds = getAnalysisArea().toFloat();
 		auto sampleRate = audioProcessor.getSampleRate();
 
-		leftPathProducer.process(fftBounds, sampleRate);
-		rightPathProducer.process(fftBounds, sampleRate);
+		//The analysis itself runs on the analysis thread, we only pick up what it finished
+		pathProducer.setRenderSettings(fftBounds, sampleRate);
+
+		auto fftOrder = static_cast<FFTOrder>(FFTOrder::order2048 + (int)audioProcessor.apvts.getRawParameterValue("Analyzer FFT Size")->load());
+		auto overlap = 1 << (int)audioProcessor.apvts.getRawParameterValue("Analyzer Overlap")->load();
+		auto mode = static_cast<AnalyzerMode>((int)audioProcessor.apvts.getRawParameterValue("Analyzer Mode")->load());
+
+		pathProducer.setAnalysisSettings(fftOrder, overlap, mode);
+		needsRepaint = pathProducer.pullLatestPaths();
 	}
 
-	if (parametersChanged.compareAndSetBool(false, true))
+	//Only bands whose parameters moved get new coefficients and have their curve re-evaluated
+	if (updateChain())
 	{
-		updateChain(); // Instance change in cover as parameter change
 		updateResponseCurve();
+		needsRepaint = true;
+	}
+
+	//A repaint can land just after the next tick, but not two ticks later unless the OS or the host held it back
+	auto lastRepaintMissed = framesWaitingForPaint > 1;
+
+	if (!showing)
+		framesWaitingForPaint = 0;
+	else if (framesWaitingForPaint > 0)
+		++framesWaitingForPaint;
+
+	if (needsRepaint && showing)
+	{
+		framesWaitingForPaint = juce::jmax(1, framesWaitingForPaint);
+		repaint();
 	}
 
+	updateFrameRate(needsRepaint, showing, lastRepaintMissed);
+}
+
+void ResponseCurveComponent::updateFrameRate(bool changed, bool showing, bool lastRepaintMissed)
+{
+	auto frameBudgetMs = 1000.0 / frameRate;
+	auto target = frameRate;
+
+	if (changed)
+		framesWithoutChanges = 0;
+	else if (framesWithoutChanges <= framesBeforeIdle)
+		++framesWithoutChanges;
+
+	if (!showing)
+		target = hiddenFrameRate;
+	else if (lastRepaintMissed || lastPaintMs > frameBudgetMs * 0.5)
+		target = juce::jmax(hiddenFrameRate, frameRate / 2); //Occluded, or the host is struggling to keep up
+	else if (changed)
+		target = juce::jmin(activeFrameRate, juce::jmax(idleFrameRate, frameRate * 2));
+	else if (framesWithoutChanges > framesBeforeIdle)
+		target = idleFrameRate;
+	else
+		target = juce::jmax(idleFrameRate, frameRate); //Just came back into view
+
+	if (target != frameRate)
+	{
+		frameRate = target;
+		startTimerHz(frameRate);
+	}
+}
+
+void ResponseCurveComponent::toggleAnalysisEnablement(bool enabled)
+{
+	shouldShowFFTAnalysis = enabled;
+	pathProducer.setActive(enabled && isShowing());
+
+	//The analyzer paths appear or disappear
+	framesWithoutChanges = 0;
 	repaint();
 }
 
+void PathProducer::setRenderSettings(juce::Rectangle<float> fftBounds, double sampleRate)
+{
+	const juce::SpinLock::ScopedLockType sl(settingsLock);
+	renderBounds = fftBounds;
+	renderSampleRate = sampleRate;
+}
+
+int PathProducer::useTimeSlice()
+{
+	juce::Rectangle<float> fftBounds;
+	double sampleRate;
+
+	{
+		const juce::SpinLock::ScopedLockType sl(settingsLock);
+		fftBounds = renderBounds;
+		sampleRate = renderSampleRate;
+	}
+
+	//Nothing to draw into yet
+	if (active.load() && !fftBounds.isEmpty() && sampleRate > 0.0)
+		process(fftBounds, sampleRate);
+
+	return analysisIntervalMs;
+}
+
 void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-	juce::AudioBuffer<float> tempIncomingBuffer;
+	//Switching order only picks another preallocated FFT, so it's fine to follow the settings every slice
+	fftDataGenerator.changeOrder(fftOrder.load());
+	const auto fftSize = fftDataGenerator.getFFTSize();
 
-	//While there are buffers to pull from Fifo, if u can pull then send it to FFT
-	while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+	if (leftChannelFifo->isPrepared() && rightChannelFifo->isPrepared())
 	{
-		if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer))
-		{
-			//Shift data forward 
-			auto size = tempIncomingBuffer.getNumSamples();
+		const auto hopSize = fftSize / overlap.load();
 
-			juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0), //Copy the buffer to zero index 
-											  monoBuffer.getReadPointer(0, size),//
-											  monoBuffer.getNumSamples() - size);
+		//processBlock fills the left fifo first, so the right one can be a block behind
+		const auto numWritten = juce::jmin(leftChannelFifo->getNumSamplesWritten(), rightChannelFifo->getNumSamplesWritten());
 
-			juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),//Copy new incoming data to 0th position
-												tempIncomingBuffer.getReadPointer(0, 0),
-												size);
+		//Fell so far behind that the ring has moved on, carry on from the newest hop
+		if (numWritten - readPosition > SampleFifo::capacity - fftSize)
+			readPosition = numWritten - hopSize;
+
+		//Only the newest frame ever reaches the screen, so jump straight to the last complete hop
+		//rather than transforming every frame in between
+		const auto numHops = (numWritten - readPosition) / hopSize;
+
+		if (numHops > 0)
+		{
+			readPosition += numHops * hopSize;
 
-			//Send mono buffer to FFT
-			leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
+			//Read the windows straight out of the rings and send them to the FFT
+			auto* left = windowBuffer.getWritePointer(0);
+			auto* right = windowBuffer.getWritePointer(1);
 
+			if (leftChannelFifo->readWindow(left, fftSize, readPosition) && rightChannelFifo->readWindow(right, fftSize, readPosition))
+			{
+				//No bin can come out louder than the peak sample, so a window this quiet draws a flat line at the floor.
+				//Once that's on screen there's no need to publish it again, which lets an idle editor stop repainting
+				auto peak = juce::jmax(juce::FloatVectorOperations::findMaximum(left, fftSize), -juce::FloatVectorOperations::findMinimum(left, fftSize),
+									   juce::FloatVectorOperations::findMaximum(right, fftSize), -juce::FloatVectorOperations::findMinimum(right, fftSize));
+				auto silent = peak < silenceThreshold;
+				auto frameSettings = std::make_tuple(fftBounds, fftSize, sampleRate, mode.load());
+
+				if (!(silent && lastWindowSilent && frameSettings == lastFrameSettings))
+					fftDataGenerator.produceFFTDataForRendering(left, right, std::get<3>(frameSettings), -48.f);
+
+				lastWindowSilent = silent;
+				lastFrameSettings = frameSettings;
+			}
 		}
 	}
 
-	const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-
 	//4800/2048 = 23Hz ,_ this is the bin width
 	const auto binWidth = sampleRate / double(fftSize);
+	const auto numBins = fftSize / 2;
 
-	//if there are FFT data buffers to pull 
-	while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+	//Build straight into the slot the message thread gets next, so there's no copy on either side.
+	//Only the newest frame is shown, so an older one still waiting is just overwritten
+	auto& latest = paths.getWriteSlot();
+	auto gotPaths = false;
+
+	while (fftDataGenerator.getNumAvailableFFTDataBlocks() > 0)
 	{
-		//if we can pull a buffer
-		std::vector<float> fftData;
-		if (leftChannelFFTDataGenerator.getFFTData(fftData))
+		//if we can pull a buffer, read it in place
+		if (auto* fftData = fftDataGenerator.acquireFFTData())
 		{
-			//generate path
-			pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+			//generate a path for each of the two spectra
+			for (size_t channel = 0; channel < latest.channels.size(); ++channel)
+				pathGenerator.generatePath(fftData->data() + channel * (size_t)numBins, fftBounds, fftSize, binWidth, -48.f, latest.channels[channel]);
+
+			fftDataGenerator.releaseFFTData();
+			gotPaths = true;
 		}
 	}
 
-	/*while there are paths that can be pulled
-		pull as many as we can
-		display the most recent path
-	*/
-	while (pathProducer.getNumPathsAvailable() > 0)
-	{
-		pathProducer.getPath(leftChannelFFTPath);
-	}
+	if (gotPaths)
+		paths.publish();
+}
+
+//The rate the processor's filters run at, so the curve shows the same bilinear warping they have
+double ResponseCurveComponent::getFilterSampleRate() const
+{
+	return audioProcessor.getSampleRate() * audioProcessor.getOversamplingFactor();
 }
 
-void ResponseCurveComponent::updateChain()
+//Picks up the coefficients of the bands that changed since the last call, returns true if any did
+bool ResponseCurveComponent::updateChain()
 {
-	auto chainSettings = getChainSettings(audioProcessor.apvts);
+	//A new sample rate or oversampling factor changes every band
+	auto sampleRate = getFilterSampleRate();
+	auto forceAll = sampleRate != chainSampleRate;
+	chainSampleRate = sampleRate;
 
-	monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-	monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-	monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+	std::array<bool, numChainPositions> changed{};
+	auto anyChanged = false;
+
+	for (size_t i = 0; i < bandVersions.size(); ++i)
+	{
+		auto version = bandVersions[i].load(std::memory_order_acquire);
+		changed[i] = forceAll || version != chainVersions[i];
+		chainVersions[i] = version;
+		anyChanged = anyChanged || changed[i];
+	}
 
-	auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-	updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+	if (!anyChanged)
+		return false;
 
-	auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-	auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+	chainSettings = getChainSettings(audioProcessor.apvts);
 
-	updateCutFilter(monoChain.get<ChainPositions::LowCut>(),
-		lowCutCoefficients,
-		chainSettings.lowCutSlope);
+	for (size_t i = 0; i < changed.size(); ++i)
+		bandCurveDirty[i] = bandCurveDirty[i] || changed[i];
 
-	updateCutFilter(monoChain.get<ChainPositions::HighCut>(),
-		highCutCoefficients,
-		chainSettings.highCutSlope);
+	//Nothing to design against until the processor has been prepared
+	if (sampleRate <= 0.0)
+		return true;
+
+	//Shared with the processors, so dragging a knob mostly hits coefficients the audio side already designed
+	if (changed[ChainPositions::Peak])
+		coefficientCache->getPeakFilter(peakCoefficients, chainSettings, sampleRate);
+	if (changed[ChainPositions::LowCut])
+		coefficientCache->getLowCutFilter(lowCutCoefficients, chainSettings, sampleRate);
+	if (changed[ChainPositions::HighCut])
+		coefficientCache->getHighCutFilter(highCutCoefficients, chainSettings, sampleRate);
+
+	return true;
 }
 
 //Get the area where we are drawing the curve  
@@ -683,7 +897,21 @@ juce::Rectangle<int> ResponseCurveComponent::getAnalysisArea()
 		lowcutBypassButtonAttachment(audioProcessor.apvts, "LowCut Bypassed", lowcutBypassButton),
 		peakBypassButtonAttachment(audioProcessor.apvts, "Peak Bypassed", peakBypassButton),
 		highcutBypassButtonAttachment(audioProcessor.apvts, "HighCut Bypassed", highcutBypassButton),
-		analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyzerEnabledButton)
+		analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyzerEnabledButton),
+
+		analyzerFFTSizeBox(*audioProcessor.apvts.getParameter("Analyzer FFT Size")),
+		analyzerOverlapBox(*audioProcessor.apvts.getParameter("Analyzer Overlap")),
+		analyzerModeBox(*audioProcessor.apvts.getParameter("Analyzer Mode")),
+		analyzerFFTSizeBoxAttachment(audioProcessor.apvts, "Analyzer FFT Size", analyzerFFTSizeBox),
+		analyzerOverlapBoxAttachment(audioProcessor.apvts, "Analyzer Overlap", analyzerOverlapBox),
+		analyzerModeBoxAttachment(audioProcessor.apvts, "Analyzer Mode", analyzerModeBox),
+
+		oversamplingBox(*audioProcessor.apvts.getParameter("Oversampling")),
+		phaseModeBox(*audioProcessor.apvts.getParameter("Phase Mode")),
+		linearPhaseLengthBox(*audioProcessor.apvts.getParameter("Linear Phase Length")),
+		oversamplingBoxAttachment(audioProcessor.apvts, "Oversampling", oversamplingBox),
+		phaseModeBoxAttachment(audioProcessor.apvts, "Phase Mode", phaseModeBox),
+		linearPhaseLengthBoxAttachment(audioProcessor.apvts, "Linear Phase Length", linearPhaseLengthBox)
 	{
 		peakFreqSlider.labels.add({ 0.f, "20Hz" });
 		peakFreqSlider.labels.add({ 1.f, "20kHz" });
@@ -855,6 +1083,14 @@ void AudioPlugin_TestAudioProcessorEditor::resized()
 
 	analyzerEnabledButton.setBounds(analyzerEnabledArea);
 
+	analyzerFFTSizeBox.setBounds(analyzerEnabledArea.withX(analyzerEnabledArea.getRight() + 5).withWidth(60));
+	analyzerOverlapBox.setBounds(analyzerFFTSizeBox.getBounds().withX(analyzerFFTSizeBox.getRight() + 5).withWidth(45));
+	analyzerModeBox.setBounds(analyzerOverlapBox.getBounds().withX(analyzerOverlapBox.getRight() + 5).withWidth(50));
+
+	oversamplingBox.setBounds(analyzerModeBox.getBounds().withX(analyzerModeBox.getRight() + 15).withWidth(50));
+	phaseModeBox.setBounds(oversamplingBox.getBounds().withX(oversamplingBox.getRight() + 5).withWidth(70));
+	linearPhaseLengthBox.setBounds(phaseModeBox.getBounds().withX(phaseModeBox.getRight() + 5).withWidth(60));
+
 	bounds.removeFromTop(5);// Space between the response curve and sliders
 
 	float hRatio = 25.f / 100.f; //JUCE_LIVE_CONSTANT(25) / 100.f;
@@ -894,6 +1130,14 @@ std::vector<juce::Component*> AudioPlugin_TestAudioProcessorEditor::getComps()
 			& lowcutBypassButton,
 			& peakBypassButton,
 			& highcutBypassButton,
-			& analyzerEnabledButton
+			& analyzerEnabledButton,
+
+			& analyzerFFTSizeBox,
+			& analyzerOverlapBox,
+			& analyzerModeBox,
+
+			& oversamplingBox,
+			& phaseModeBox,
+			& linearPhaseLengthBox
     };
 }
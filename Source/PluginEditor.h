@@ -10,6 +10,8 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SpectrumKernels.h"
+#include "MagnitudeResponse.h"
 
 enum FFTOrder
 {
@@ -18,157 +20,225 @@ enum FFTOrder
     order8192 = 13
 };
 
+//Which pair of spectra the analyzer shows
+enum class AnalyzerMode
+{
+    leftRight,
+    midSide
+};
+
+/*
+ Produces a pair of spectra per frame from one complex FFT: the left channel goes into the
+ real part, the right into the imaginary part, and the two spectra are separated afterwards
+ using the conjugate symmetry of real signals. Mid and side are linear in left and right,
+ so they come out of the same transform.
+ Each fifo slot holds the first spectrum in [0, numBins) and the second in [numBins, 2 * numBins).
+ */
 template<typename BlockType>
 struct FFTDataGenerator
 {
+    static constexpr int numOrders = FFTOrder::order8192 - FFTOrder::order2048 + 1;
+
+    //Every order's FFT, window and fifo storage is set up here, so changeOrder never allocates
+    FFTDataGenerator()
+    {
+        for (int i = 0; i < numOrders; ++i)
+        {
+            auto fftSize = 1 << (FFTOrder::order2048 + i);
+            forwardFFTs[(size_t)i] = std::make_unique<juce::dsp::FFT>(FFTOrder::order2048 + i);
+
+            //Same table juce::dsp::WindowingFunction would hold, but we apply it while packing the input
+            windowTables[(size_t)i].resize((size_t)fftSize);
+            juce::dsp::WindowingFunction<float>::fillWindowingTables(windowTables[(size_t)i].data(),
+                                                                     (size_t)fftSize,
+                                                                     juce::dsp::WindowingFunction<float>::blackmanHarris,
+                                                                     true);
+        }
+
+        packed.resize((size_t)getMaxFFTSize());
+        spectrum.resize((size_t)getMaxFFTSize());
+        fftDataFifo.prepare((size_t)getMaxFFTSize());
+    }
+
     /**
-     produces the FFT data from an audio buffer.
+     produces the FFT data from the last fftSize samples of both channels.
      */
     //Feed audio into FFT
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    void produceFFTDataForRendering(const float* left, const float* right, AnalyzerMode mode, const float negativeInfinity)
     {
-        const auto fftSize = getFFTSize();
+        //Separate straight into a free slot of the fifo, so nothing gets copied afterwards
+        auto* slot = fftDataFifo.reserveWrite();
+        if (slot == nullptr)
+            return; //the GUI hasn't caught up, this frame would have been dropped anyway
 
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+        auto& fftData = *slot;
+        const auto fftSize = getFFTSize();
+        const auto* windowTable = windowTables[(size_t)(order - FFTOrder::order2048)].data();
+        auto& forwardFFT = *forwardFFTs[(size_t)(order - FFTOrder::order2048)];
 
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
+        //Window both channels while packing them into one complex signal
+        for (int i = 0; i < fftSize; ++i)
+            packed[(size_t)i] = { left[i] * windowTable[i], right[i] * windowTable[i] };
 
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
+        //One transform for both channels
+        forwardFFT.perform(packed.data(), spectrum.data(), false);
 
-        int numBins = (int)fftSize / 2;
+        const int numBins = (int)fftSize / 2;
+        auto* first = fftData.data();
+        auto* second = first + numBins;
 
-        //normalize the fft values.
-        for (int i = 0; i < numBins; ++i)
+        //Z[k] = L[k] + i R[k], and L and R are conjugate symmetric, so
+        //L[k] = (Z[k] + conj(Z[N - k])) / 2 and R[k] = (Z[k] - conj(Z[N - k])) / 2i
+        for (int k = 0; k < numBins; ++k)
         {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if (!std::isinf(v) && !std::isnan(v))
+            auto z = spectrum[(size_t)k];
+            auto mirrored = std::conj(spectrum[(size_t)((fftSize - k) & (fftSize - 1))]);
+
+            auto l = (z + mirrored) * 0.5f;
+            auto r = (z - mirrored) * juce::dsp::Complex<float>(0.f, -0.5f);
+
+            if (mode == AnalyzerMode::midSide)
             {
-                v /= float(numBins);
+                first[k] = std::abs((l + r) * 0.5f);
+                second[k] = std::abs((l - r) * 0.5f);
             }
             else
             {
-                v = 0.f;
+                first[k] = std::abs(l);
+                second[k] = std::abs(r);
             }
-            fftData[i] = v;
         }
 
-        //convert them to decibels
-        for (int i = 0; i < numBins; ++i)
-        {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-        }
+        //normalize the fft values and convert them to decibels, both spectra in one go
+        if (postProcessing == SpectrumPostProcessing::fast)
+            SpectrumKernels::magnitudesToDecibels(fftData.data(), numBins * 2, 1.f / float(numBins), negativeInfinity);
+        else
+            SpectrumKernels::magnitudesToDecibelsReference(fftData.data(), numBins * 2, 1.f / float(numBins), negativeInfinity);
 
-        fftDataFifo.push(fftData);
+        fftDataFifo.commitWrite();
     }
 
+    //Just picks one of the preallocated orders. Call it from the thread that produces and reads the data
     void changeOrder(FFTOrder newOrder)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
-
         order = newOrder;
-        auto fftSize = getFFTSize();
-
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+    }
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
+    //The reference path is only there to check the fast one against
+    void setPostProcessing(SpectrumPostProcessing newPostProcessing) { postProcessing = newPostProcessing; }
 
-        fftDataFifo.prepare(fftData.size());
-    }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
+    static constexpr int getMaxFFTSize() { return 1 << FFTOrder::order8192; }
+    FFTOrder getOrder() const { return order; }
 
     //How much FFT data is available 
     int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
 
     //==============================================================================
-    //Get FFT data
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+    //Read the oldest FFT data in place, then release it
+    const BlockType* acquireFFTData() { return fftDataFifo.acquireRead(); }
+    void releaseFFTData() { fftDataFifo.releaseRead(); }
 
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-
-    Fifo<BlockType> fftDataFifo;
+    FFTOrder order = FFTOrder::order2048;
+    std::array<std::unique_ptr<juce::dsp::FFT>, numOrders> forwardFFTs;
+    std::array<std::vector<float>, numOrders> windowTables;
+    std::vector<juce::dsp::Complex<float>> packed, spectrum;
+    SpectrumPostProcessing postProcessing = SpectrumPostProcessing::fast;
+
+    //Frames are turned into paths right after they are produced, so one slot is plenty
+    Fifo<BlockType> fftDataFifo{ 2 };
 };
 
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' (the first fftSize / 2 values) into 'p', in the coordinates of the component fftBounds belongs to.
+     'p' keeps its storage, so building into the same path every frame doesn't allocate
      */
-    void generatePath(const std::vector<float>& renderData,
+    void generatePath(const float* renderData,
         juce::Rectangle<float> fftBounds,
         int fftSize,
         float binWidth,
-        float negativeInfinity)
+        float negativeInfinity,
+        PathType& p)
     {
+        auto left = fftBounds.getX();
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
-        auto width = fftBounds.getWidth();
 
-        int numBins = (int)fftSize / 2;
+        updateColumnTable(fftBounds.getWidth(), fftSize, binWidth);
+
+        p.clear();
 
-        PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        if (columns.empty())
+            return;
 
+        p.preallocateSpace(3 * ((int)columns.size() + 1));
+
+        //Same mapping as the path used to get at the origin, shifted to where paint draws it
         auto map = [bottom, top, negativeInfinity](float v)
         {
-            return juce::jmap(v,
+            return top + juce::jmap(v,
                 negativeInfinity, 0.f,
                 float(bottom + 10), top);
         };
 
-        auto y = map(renderData[0]);
+        //One point per pixel column, at the loudest bin that lands in it.
+        //The generator floors every bin at negativeInfinity, so there's no NaN or inf to filter here
+        auto getColumnLevel = [&renderData](const Column& column)
+        {
+            return *std::max_element(renderData + column.startBin, renderData + column.endBin);
+        };
 
-        //        jassert( !std::isnan(y) && !std::isinf(y) );
-        if (std::isnan(y) || std::isinf(y))
-            y = bottom;
+        p.startNewSubPath(left + (float)columns.front().x, map(getColumnLevel(columns.front())));
 
-        p.startNewSubPath(0, y);
+        for (size_t i = 1; i < columns.size(); ++i)
+            p.lineTo(left + (float)columns[i].x, map(getColumnLevel(columns[i])));
+    }
 
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
+private:
+    //Bins [startBin, endBin) all fall into pixel column x
+    struct Column
+    {
+        int x, startBin, endBin;
+    };
 
-        for (int binNum = 1; binNum < numBins; binNum += pathResolution)
-        {
-            y = map(renderData[binNum]);
+    std::vector<Column> columns;
+    float tableWidth = 0.f, tableBinWidth = 0.f;
+    int tableFFTSize = 0;
 
-            //            jassert( !std::isnan(y) && !std::isinf(y) );
+    //Only rebuilt when the FFT size, sample rate or width changes
+    void updateColumnTable(float width, int fftSize, float binWidth)
+    {
+        if (width == tableWidth && fftSize == tableFFTSize && binWidth == tableBinWidth)
+            return;
 
-            if (!std::isnan(y) && !std::isinf(y))
-            {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
-            }
-        }
+        tableWidth = width;
+        tableFFTSize = fftSize;
+        tableBinWidth = binWidth;
 
-        pathFifo.push(p);
-    }
+        columns.clear();
 
-    int getNumPathsAvailable() const
-    {
-        return pathFifo.getNumAvailableForReading();
-    }
+        const int numBins = fftSize / 2;
+        for (int binNum = 1; binNum < numBins; ++binNum)
+        {
+            auto binFreq = binNum * binWidth;
+            if (binFreq < 20.f)
+                continue;
+            if (binFreq > 20000.f)
+                break;
 
-    bool getPath(PathType& path)
-    {
-        return pathFifo.pull(path);
+            int binX = (int)std::floor(juce::mapFromLog10(binFreq, 20.f, 20000.f) * width);
+
+            if (columns.empty() || columns.back().x != binX)
+                columns.push_back({ binX, binNum, binNum + 1 });
+            else
+                columns.back().endBin = binNum + 1;
+        }
     }
-private:
-    Fifo<PathType> pathFifo;
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4
@@ -215,30 +285,90 @@ private:
     juce::String suffix;
 };
 
-struct PathProducer
+//One background thread per process that runs the spectrum analysis for every open editor
+struct AnalysisThread : juce::TimeSliceThread
 {
-    PathProducer(SingleChannelSampleFifo<AudioPlugin_TestAudioProcessor::BlockType>& scsf) :
-        leftChannelFifo(&scsf)
+    AnalysisThread() : juce::TimeSliceThread("Spectrum Analysis") { startThread(); }
+    ~AnalysisThread() override { stopThread(1000); }
+};
+
+//Both analyzer paths of one frame, published together, already in the response curve's coordinates
+struct AnalyzerPaths
+{
+    //Left and right, or mid and side
+    std::array<juce::Path, 2> channels;
+};
+
+/*
+ Turns the processor's two analyzer fifos into a pair of spectrum paths.
+ The FFT and path building run on the AnalysisThread, the message thread only
+ hands over the render settings and picks up the newest finished paths.
+ */
+struct PathProducer : juce::TimeSliceClient
+{
+    using SampleFifo = decltype(AudioPlugin_TestAudioProcessor::leftChannelFifo);
+
+    PathProducer(SampleFifo& left, SampleFifo& right) :
+        leftChannelFifo(&left),
+        rightChannelFifo(&right)
     {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        windowBuffer.setSize(2, FFTDataGenerator<std::vector<float>>::getMaxFFTSize());
     }
 
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
+    //Message thread
+    void setRenderSettings(juce::Rectangle<float> fftBounds, double sampleRate);
+    void setActive(bool shouldBeActive) { active.store(shouldBeActive); }
+
+    //A new frame every fftSize / overlap samples, whatever block size the host uses
+    void setAnalysisSettings(FFTOrder newOrder, int newOverlap, AnalyzerMode newMode)
+    {
+        fftOrder.store(newOrder);
+        overlap.store(juce::jmax(1, newOverlap));
+        mode.store(newMode);
+    }
+
+    //Message thread: swaps in the newest paths from the analysis thread, returns false if there's nothing new
+    bool pullLatestPaths() { return paths.acquireLatest(); }
+    const AnalyzerPaths& getPaths() const { return paths.getReadSlot(); }
+
+    //Analysis thread
+    int useTimeSlice() override;
 
 private:
-    SingleChannelSampleFifo<AudioPlugin_TestAudioProcessor::BlockType>* leftChannelFifo;
+    void process(juce::Rectangle<float> fftBounds, double sampleRate);
+
+    static constexpr int analysisIntervalMs = 15;
+
+    SampleFifo* leftChannelFifo;
+    SampleFifo* rightChannelFifo;
+
+    //Position in the fifos of the last window we analysed
+    juce::int64 readPosition = 0;
+
+    //6 dB under the -48 dB floor, leaves room for M/S summing both channels
+    const float silenceThreshold = juce::Decibels::decibelsToGain(-54.f);
+    bool lastWindowSilent = false;
+    std::tuple<juce::Rectangle<float>, int, double, AnalyzerMode> lastFrameSettings;
 
-    //Fill with blocks of audio from left to right (First come first out)
-    juce::AudioBuffer<float> monoBuffer;
+    //The windows handed to the FFT, one channel each
+    juce::AudioBuffer<float> windowBuffer;
 
-    //FFT data generator
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+    //FFT data generator, both channels in one transform
+    FFTDataGenerator<std::vector<float>> fftDataGenerator;
 
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    //Both spectra share the bin to column table, so one generator does both paths
+    AnalyzerPathGenerator<juce::Path> pathGenerator;
 
-    juce::Path leftChannelFFTPath;
+    //Finished paths, written by the analysis thread and read by the message thread
+    TripleBuffer<AnalyzerPaths> paths;
+
+    juce::SpinLock settingsLock;
+    juce::Rectangle<float> renderBounds;
+    double renderSampleRate = 0.0;
+    std::atomic<bool> active{ true };
+    std::atomic<FFTOrder> fftOrder{ FFTOrder::order2048 };
+    std::atomic<int> overlap{ 4 };
+    std::atomic<AnalyzerMode> mode{ AnalyzerMode::leftRight };
 };
 
 // As responseCurve is the component of editor now we will not draw out of our bounds
@@ -257,24 +387,62 @@ struct ResponseCurveComponent : juce::Component,juce::AudioProcessorParameter::L
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    void toggleAnalysisEnablement(bool enabled){shouldShowFFTAnalysis = enabled;}
+    void toggleAnalysisEnablement(bool enabled);
 private:
     AudioPlugin_TestAudioProcessor& audioProcessor;
 
     bool shouldShowFFTAnalysis = true;
 
-    juce::Atomic<bool> parametersChanged{ false };
-
-    MonoChain monoChain;
+    //Bumped by the parameter listener for the band the parameter belongs to, from whatever thread the host uses
+    std::array<std::atomic<juce::uint32>, numChainPositions> bandVersions{};
+
+    //What the curve shows, filled in by updateChain for the bands that changed
+    std::array<juce::uint32, numChainPositions> chainVersions{};
+    double chainSampleRate = -1.0;
+    ChainSettings chainSettings;
+    BiquadCoeffs peakCoefficients;
+    CutCoeffs lowCutCoefficients, highCutCoefficients;
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+
+    //Each band's own dB curve, so a change to one band only re-evaluates that band
+    MagnitudeResponseEvaluator responseEvaluator;
+    std::array<std::vector<double>, numChainPositions> bandCurves;
+    std::array<bool, numChainPositions> bandCurveDirty{ true, true, true };
+    std::vector<double> responseDecibels;
+    int curveWidth = 0;
+    double curveSampleRate = 0.0;
 
     void updateResponseCurve();
+    void updateBandCurve(int band);
 
     juce::Path responseCurve;
 
-    void updateChain();
+    bool updateChain();
+    double getFilterSampleRate() const;
 
     void drawBackgroundGrid(juce::Graphics& g);
     void drawTextLabels(juce::Graphics& g);
+    void drawBorder(juce::Graphics& g);
+
+    //The timer runs fast while something is moving and backs off when nothing changes,
+    //when we're hidden, or when repaints stop getting through (occluded window, busy host)
+    static constexpr int activeFrameRate = 60;
+    static constexpr int idleFrameRate = 10;
+    static constexpr int hiddenFrameRate = 2;
+    static constexpr int framesBeforeIdle = 30;
+
+    int frameRate = activeFrameRate;
+    int framesWithoutChanges = 0;
+    int framesWaitingForPaint = 0;
+    double lastPaintMs = 0.0;
+
+    void updateFrameRate(bool changed, bool showing, bool lastRepaintMissed);
+
+    //Grid underneath the paths, border and labels on top of them. Only redrawn on resize or a new display scale
+    juce::Image backgroundLayer, foregroundLayer;
+    float layerScale = 0.f;
+
+    void updateStaticLayers(float scale);
 
     std::vector<float> getFrequencies();
     std::vector<float> getGains();
@@ -284,12 +452,23 @@ private:
 
     juce::Rectangle<int> getAnalysisArea();
 
-    PathProducer leftPathProducer, rightPathProducer;
+    juce::SharedResourcePointer<AnalysisThread> analysisThread;
+    PathProducer pathProducer;
 };
 
 //==============================================================================
 struct PowerButton : juce::ToggleButton { };
 
+//Filled with the choices of the parameter it's going to be attached to
+struct ParameterComboBox : juce::ComboBox
+{
+    ParameterComboBox(juce::RangedAudioParameter& rap)
+    {
+        if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(&rap))
+            addItemList(choiceParam->choices, 1);
+    }
+};
+
 struct AnalyzerButton : juce::ToggleButton
 {
     void resized() override
@@ -355,6 +534,15 @@ private:
 	using ButtonAttachment = APVTS::ButtonAttachment;
 	ButtonAttachment lowcutBypassButtonAttachment,peakBypassButtonAttachment,highcutBypassButtonAttachment,analyzerEnabledButtonAttachment;
 
+	//analyzer settings
+	ParameterComboBox analyzerFFTSizeBox, analyzerOverlapBox, analyzerModeBox;
+	using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+	ComboBoxAttachment analyzerFFTSizeBoxAttachment, analyzerOverlapBoxAttachment, analyzerModeBoxAttachment;
+
+	//processing settings
+	ParameterComboBox oversamplingBox, phaseModeBox, linearPhaseLengthBox;
+	ComboBoxAttachment oversamplingBoxAttachment, phaseModeBoxAttachment, linearPhaseLengthBoxAttachment;
+
     //customize look n feel component
 	LookAndFeel lnf;
 
@@ -9,6 +9,11 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//The headless tools build the processor without the plugin wrapper's defines
+#ifndef JucePlugin_Name
+ #define JucePlugin_Name "AudioPlugin_Test"
+#endif
+
 //==============================================================================
 AudioPlugin_TestAudioProcessor::AudioPlugin_TestAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -22,10 +27,36 @@ AudioPlugin_TestAudioProcessor::AudioPlugin_TestAudioProcessor()
                        )
 #endif
 {
+	//Listen to every parameter so we only redesign the band that actually moved
+	for (auto* param : getParameters())
+	{
+		auto position = -1;
+		if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+			position = getChainPositionForParameter(paramWithID->paramID);
+
+		parameterChainPositions.push_back(position);
+		param->addListener(this);
+	}
+
+	analyzerEnabled = apvts.getRawParameterValue("Analyzer Enabled");
+	oversamplingChoice = apvts.getRawParameterValue("Oversampling");
+	phaseModeChoice = apvts.getRawParameterValue("Phase Mode");
+	linearPhaseLengthChoice = apvts.getRawParameterValue("Linear Phase Length");
+
+	designThread->addTimeSliceClient(this);
+	startTimer(hostNotificationIntervalMs);
 }
 
 AudioPlugin_TestAudioProcessor::~AudioPlugin_TestAudioProcessor()
 {
+	//Waits for a design pass that might be running right now
+	designThread->removeTimeSliceClient(this);
+	stopTimer();
+
+	for (auto* param : getParameters())
+	{
+		param->removeListener(this);
+	}
 }
 
 //==============================================================================
@@ -63,7 +94,7 @@ bool AudioPlugin_TestAudioProcessor::isMidiEffect() const
 
 double AudioPlugin_TestAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int AudioPlugin_TestAudioProcessor::getNumPrograms()
@@ -96,16 +127,53 @@ void AudioPlugin_TestAudioProcessor::prepareToPlay (double sampleRate, int sampl
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need..
 
-	//Prepare the filters before using them by passing processSpec to chain (monochain)
-	juce::dsp::ProcessSpec spec;
-	spec.maximumBlockSize = samplesPerBlock;
-	spec.numChannels = 1;
-	spec.sampleRate = sampleRate;
+	//The host picks the precision before preparing, and can only change it by preparing again
+	auto numChannels = getTotalNumOutputChannels();
+	preparedDoublePrecision = isUsingDoublePrecision();
 
-	leftChain.prepare(spec);
-	rightChain.prepare(spec);
+	if (preparedDoublePrecision)
+	{
+		prepareEngines(doubleEngines, sampleRate, samplesPerBlock, numChannels);
+		releaseEngines(floatEngines);
+	}
+	else
+	{
+		prepareEngines(floatEngines, sampleRate, samplesPerBlock, numChannels);
+		releaseEngines(doubleEngines);
+	}
+
+	{
+		//The design thread might be writing a kernel right now
+		const juce::ScopedLock sl(designLock);
+		linearPhase.prepare(numChannels);
+		designedKernelLength = 0;
+		kernelDesignPending = false;
+	}
 
-	updateFilters();//Update all the filters
+	//Oversampling (and so the latency) is fixed for the whole render from here on
+	preparedNonRealtime.store(isNonRealtime());
+
+	//Audio isn't running yet, so design and pick up the coefficients right here.
+	//The storage was just reset, so every band has to be applied again.
+	//This also warms the shared coefficient cache for the new sample rate
+	designSampleRate.store(sampleRate);
+	markAllBandsChanged();
+	designChainCoefficients();
+
+	activeOversamplingFactor = 0; //whatever was designed counts as a switch, so the latency gets worked out
+	if (publishedCoefficients.acquireLatest())
+		updateFilters(publishedCoefficients.getReadSlot());//Update all the filters
+
+	linearPhaseActive = false;
+	updateLinearPhase();
+
+	//We're not processing yet, so the host can have the latency straight away
+	reportedLatency = getProcessingLatency();
+	pendingLatencySamples.store(reportedLatency);
+	setLatencySamples(reportedLatency);
+
+	silentSamples = 0;
+	dspSleeping = false;
 
 	//Preparing the channel Fifo
 	leftChannelFifo.prepare(samplesPerBlock);
@@ -114,11 +182,76 @@ void AudioPlugin_TestAudioProcessor::prepareToPlay (double sampleRate, int sampl
 	//Create sin wave
 	osc.initialise([](float x) { return std::sin(x); });
 
+	juce::dsp::ProcessSpec spec;
+	spec.maximumBlockSize = samplesPerBlock;
 	spec.numChannels = getTotalNumOutputChannels();
+	spec.sampleRate = sampleRate;
 	osc.prepare(spec);
 	osc.setFrequency(440);
 }
 
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::prepareEngines(ChainEngines<SampleType>& engines, double sampleRate, int samplesPerBlock, int numChannels)
+{
+	//Prepare the filters before using them by passing processSpec to chain (monochain)
+	juce::dsp::ProcessSpec spec;
+	spec.maximumBlockSize = samplesPerBlock;
+	spec.numChannels = 1;
+	spec.sampleRate = sampleRate;
+
+	//One MonoChain per channel of whatever layout the host gave us.
+	//Coefficients get overwritten in place from now on, so allocate their storage here
+	while (engines.channelChains.size() < numChannels)
+		engines.channelChains.add(new MonoChain<SampleType>());
+
+	for (auto* chain : engines.channelChains)
+	{
+		prepareCoefficientStorage(*chain);
+		chain->prepare(spec);
+	}
+
+	//The filters may run at up to maxOversamplingFactor times the block size
+	engines.simdChain.prepare(numChannels, samplesPerBlock * maxOversamplingFactor);
+
+	//Both factors are ready to go, switching between them on the audio thread doesn't allocate
+	if (engines.numOversamplerChannels != numChannels)
+	{
+		for (size_t i = 0; i < engines.oversamplers.size(); ++i)
+			engines.oversamplers[i] = std::make_unique<juce::dsp::Oversampling<SampleType>>((size_t)numChannels,
+																						 i + 1,
+																						 juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+																						 true,   //max quality
+																						 true);  //integer latency, so it can be reported exactly
+
+		engines.numOversamplerChannels = numChannels;
+	}
+
+	for (auto& oversampler : engines.oversamplers)
+	{
+		oversampler->initProcessing((size_t)samplesPerBlock);
+		oversampler->reset();
+	}
+}
+
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::releaseEngines(ChainEngines<SampleType>& engines)
+{
+	engines.channelChains.clear();
+	engines.simdChain = {};
+
+	for (auto& oversampler : engines.oversamplers)
+		oversampler.reset();
+
+	engines.numOversamplerChannels = 0;
+}
+
+template<typename SampleType>
+juce::dsp::Oversampling<SampleType>& AudioPlugin_TestAudioProcessor::getOversampler(ChainEngines<SampleType>& engines, int factor)
+{
+	jassert(factor == 2 || factor == 4);
+	return *engines.oversamplers[factor == 2 ? 0 : 1];
+}
+
 void AudioPlugin_TestAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
@@ -133,11 +266,10 @@ bool AudioPlugin_TestAudioProcessor::isBusesLayoutSupported (const BusesLayout&
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel gets the same EQ, so anything from mono up to immersive
+    // beds like 7.1.4 works as long as it fits in the channel pool.
+    auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels == 0 || numChannels > maxNumChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -152,6 +284,21 @@ bool AudioPlugin_TestAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 #endif
 
 void AudioPlugin_TestAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+	juce::ignoreUnused(midiMessages);
+	jassert(!preparedDoublePrecision);
+	processSamples(buffer, floatEngines);
+}
+
+void AudioPlugin_TestAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+	juce::ignoreUnused(midiMessages);
+	jassert(preparedDoublePrecision);
+	processSamples(buffer, doubleEngines);
+}
+
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer, ChainEngines<SampleType>& engines)
 {
 	juce::ScopedNoDenormals noDenormals;
 	auto totalNumInputChannels = getTotalNumInputChannels();
@@ -166,7 +313,13 @@ void AudioPlugin_TestAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, buffer.getNumSamples());
 
-	updateFilters();//Update all the filters
+	//Offline renders can't wait for the design thread to catch up with automation
+	if (isNonRealtime())
+		designChainCoefficients();
+
+	//Only touch the filters when the design thread published something new
+	if (publishedCoefficients.acquireLatest())
+		updateFilters(publishedCoefficients.getReadSlot());
 
 	// This is the place where you'd normally do the guts of your plugin's
 	// audio processing...
@@ -180,20 +333,120 @@ void AudioPlugin_TestAudioProcessor::processBlock (juce::AudioBuffer<float>& buf
 	//    // ..do something to the data...
 	//}
 
-	juce::dsp::AudioBlock<float> block(buffer);//Audio block wrapping this buffer
+	//Switching engines: the other one has stale state from whenever it last ran
+	auto mode = processingMode.load();
+	if (mode != activeProcessingMode)
+	{
+		resetFilterState();
+		activeProcessingMode = mode;
+	}
+
+	updateLinearPhase();
 
-	auto leftBlock = block.getSingleChannelBlock(0);
-	auto rightBlock = block.getSingleChannelBlock(1);
+	auto numChannels = juce::jmin(totalNumInputChannels, engines.channelChains.size());
+	auto numSamples = buffer.getNumSamples();
+
+	//Bails out on the first sample above 'threshold', so normal material only costs a compare or two
+	auto isSilent = [&buffer, numChannels, numSamples](SampleType threshold)
+	{
+		for (int channel = 0; channel < numChannels; ++channel)
+		{
+			auto* data = buffer.getReadPointer(channel);
+			for (int i = 0; i < numSamples; ++i)
+				if (std::abs(data[i]) > threshold)
+					return false;
+		}
 
-	juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-	juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+		return true;
+	};
 
-	leftChain.process(leftContext);
-	rightChain.process(rightContext);
+	//Only digital silence counts, quiet material (fade outs, dithered noise floors) still goes through the filters
+	auto inputIsSilent = isSilent(SampleType(0));
 
-	//Push buffer into Fifo
-	leftChannelFifo.update(buffer);
-	rightChannelFifo.update(buffer);
+	if (!inputIsSilent)
+	{
+		silentSamples = 0;
+		dspSleeping = false;
+	}
+	else
+	{
+		silentSamples += numSamples;
+	}
+
+	//While asleep there's nothing to ring out and the input is all zeros, so it passes straight through
+	if (!dspSleeping && numChannels > 0)
+	{
+		if (linearPhaseActive)
+		{
+			linearPhase.process(buffer.getArrayOfWritePointers(), numChannels, numSamples);
+		}
+		else
+		{
+			auto block = juce::dsp::AudioBlock<SampleType>(buffer).getSubsetChannelBlock(0, (size_t)numChannels);
+
+			if (activeOversamplingFactor > 1)
+			{
+				//Filter at the higher rate, where the bilinear transform doesn't squash the top octaves
+				auto& oversampler = getOversampler(engines, activeOversamplingFactor);
+				processFilters(oversampler.processSamplesUp(block), engines, mode);
+				oversampler.processSamplesDown(block);
+			}
+			else
+			{
+				processFilters(block, engines, mode);
+			}
+		}
+	}
+
+	//The tail has passed and what's left of it is below the threshold, flush the state and go to sleep.
+	//This block's output is kept as it is, only the residue still in the filters is dropped
+	auto activeTailSamples = linearPhaseActive ? linearPhase.getTailSamples() : tailSamples;
+	if (inputIsSilent && !dspSleeping && silentSamples >= activeTailSamples)
+	{
+		if (isSilent((SampleType)silenceThreshold))
+		{
+			resetFilterState();
+			dspSleeping = true;
+		}
+	}
+
+	//Push buffer into Fifo, but only if an editor is actually showing the analyzer
+	if (shouldFeedAnalyzer())
+	{
+		leftChannelFifo.update(buffer);
+		rightChannelFifo.update(buffer);
+	}
+}
+
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::processFilters(juce::dsp::AudioBlock<SampleType> block, ChainEngines<SampleType>& engines, ProcessingMode mode)
+{
+	auto numChannels = (int)block.getNumChannels();
+	auto numSamples = (int)block.getNumSamples();
+
+	if (mode == ProcessingMode::simd)
+	{
+		std::array<SampleType*, maxNumChannels> channels{};
+		for (int channel = 0; channel < numChannels; ++channel)
+			channels[(size_t)channel] = block.getChannelPointer((size_t)channel);
+
+		engines.simdChain.process(channels.data(), numChannels, numSamples);
+	}
+	else
+	{
+		for (int channel = 0; channel < numChannels; ++channel)
+		{
+			auto channelBlock = block.getSingleChannelBlock((size_t)channel);
+			juce::dsp::ProcessContextReplacing<SampleType> context(channelBlock);
+			engines.channelChains.getUnchecked(channel)->process(context);
+		}
+	}
+}
+
+bool AudioPlugin_TestAudioProcessor::shouldFeedAnalyzer() const
+{
+	return numAnalyzerConsumers.load(std::memory_order_relaxed) > 0
+		&& analyzerEnabled->load(std::memory_order_relaxed) > 0.5f;
 }
 
 //==============================================================================
@@ -227,7 +480,7 @@ void AudioPlugin_TestAudioProcessor::setStateInformation (const void* data, int
 	if (tree.isValid())
 	{
 		apvts.replaceState(tree);
-		updateFilters();
+		markAllBandsChanged();
 	}
 }
 
@@ -251,69 +504,420 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
 	return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+int getChainPositionForParameter(const juce::String& parameterID)
 {
-	return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-																chainSettings.peakFreq,
-																chainSettings.peakQuality,
-																juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+	if (parameterID.startsWith("LowCut"))
+		return ChainPositions::LowCut;
+	if (parameterID.startsWith("Peak"))
+		return ChainPositions::Peak;
+	if (parameterID.startsWith("HighCut"))
+		return ChainPositions::HighCut;
+
+	return -1;
 }
 
-void AudioPlugin_TestAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
+BiquadCoeffs makeLowPassBiquad(double sampleRate, double frequency, double quality)
 {
-	auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+	auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+	auto nSquared = n * n;
+	auto invQ = 1.0 / quality;
+	auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+	return { c1, c1 * 2.0, c1, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+}
 
-	leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-	rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+BiquadCoeffs makeHighPassBiquad(double sampleRate, double frequency, double quality)
+{
+	auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+	auto nSquared = n * n;
+	auto invQ = 1.0 / quality;
+	auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
 
-	updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+	return { c1, c1 * -2.0, c1, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared) };
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements)
+BiquadCoeffs makePeakBiquad(double sampleRate, double frequency, double quality, double gainFactor)
 {
-	*old = *replacements;
+	auto A = juce::jmax(0.0, std::sqrt(gainFactor));
+	auto omega = (juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0)) / sampleRate;
+	auto alpha = std::sin(omega) / (quality * 2.0);
+	auto c2 = -2.0 * std::cos(omega);
+	auto alphaTimesA = alpha * A;
+	auto alphaOverA = alpha / A;
+	auto a0 = 1.0 + alphaOverA;
+
+	return { (1.0 + alphaTimesA) / a0, c2 / a0, (1.0 - alphaTimesA) / a0, c2 / a0, (1.0 - alphaOverA) / a0 };
 }
 
-void AudioPlugin_TestAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+//Order 2, 4, 6, 8 -> 1 to 4 sections, each with its own Q taken from the Butterworth pole angles
+static double getButterworthSectionQuality(int section, int order)
 {
-	//LowCutFilter
-	auto LowCutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-	auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-	auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+	return 1.0 / (2.0 * std::cos((2.0 * section + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+}
+
+void designButterworthHighPass(CutCoeffs& coefficients, double frequency, double sampleRate, Slope slope)
+{
+	auto order = 2 * (slope + 1);
+	coefficients.numStages = order / 2;
+
+	for (int i = 0; i < coefficients.numStages; ++i)
+		coefficients.stages[(size_t)i] = makeHighPassBiquad(sampleRate, frequency, getButterworthSectionQuality(i, order));
+}
 
-	leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-	rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+void designButterworthLowPass(CutCoeffs& coefficients, double frequency, double sampleRate, Slope slope)
+{
+	auto order = 2 * (slope + 1);
+	coefficients.numStages = order / 2;
 
-	updateCutFilter(rightLowCut, LowCutCoefficients, chainSettings.lowCutSlope);
-	updateCutFilter(leftLowCut, LowCutCoefficients, chainSettings.lowCutSlope);
+	for (int i = 0; i < coefficients.numStages; ++i)
+		coefficients.stages[(size_t)i] = makeLowPassBiquad(sampleRate, frequency, getButterworthSectionQuality(i, order));
 }
 
-void AudioPlugin_TestAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
+void designPeakFilter(BiquadCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
 {
-	//HighCutFilter
-	auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+	coefficients = makePeakBiquad(sampleRate,
+								  chainSettings.peakFreq,
+								  chainSettings.peakQuality,
+								  juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+}
+
+void designLowCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+	designButterworthHighPass(coefficients, chainSettings.lowCutFreq, sampleRate, chainSettings.lowCutSlope);
+}
+
+void designHighCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate)
+{
+	designButterworthLowPass(coefficients, chainSettings.highCutFreq, sampleRate, chainSettings.highCutSlope);
+}
+
+//Can be called from any thread, including the audio thread during automation
+void AudioPlugin_TestAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+	juce::ignoreUnused(newValue);
 
-	auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-	auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+	auto position = getChainPositionForParameterIndex(parameterIndex);
+	if (position >= 0)
+		bandVersions[(size_t)position].fetch_add(1, std::memory_order_release);
+}
 
-	leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-	rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+void AudioPlugin_TestAudioProcessor::markAllBandsChanged()
+{
+	for (auto& version : bandVersions)
+		version.fetch_add(1, std::memory_order_release);
+}
 
-	updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-	updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+int AudioPlugin_TestAudioProcessor::useTimeSlice()
+{
+	designChainCoefficients();
+	return designPollIntervalMs;
 }
 
-void AudioPlugin_TestAudioProcessor::updateFilters()
+bool AudioPlugin_TestAudioProcessor::designChainCoefficients()
 {
+	const juce::ScopedLock sl(designLock);
+
+	auto hostSampleRate = designSampleRate.load();
+	if (hostSampleRate <= 0.0)
+		return false;
+
+	//Design for the rate the filters actually run at
+	auto oversamplingFactor = getOversamplingFactorToDesign();
+	auto sampleRate = hostSampleRate * oversamplingFactor;
+
+	//A new sample rate or oversampling factor invalidates everything we designed so far
+	auto forceAll = sampleRate != designedSampleRate;
+	designedSampleRate = sampleRate;
+
+	//Read the versions before the parameters, so a change racing with us just triggers another pass
+	std::array<bool, numChainPositions> changed{};
+	auto anyChanged = false;
+
+	for (size_t i = 0; i < bandVersions.size(); ++i)
+	{
+		auto version = bandVersions[i].load(std::memory_order_acquire);
+		changed[i] = forceAll || version != designedBandVersions[i];
+		designedBandVersions[i] = version;
+		anyChanged = anyChanged || changed[i];
+	}
+
+	//Linear phase needs a kernel for the chain as well, whenever the chain or the kernel length changes
+	auto kernelLength = getLinearPhaseLengthToDesign();
+	auto kernelOutdated = kernelLength > 0
+		&& (linearPhaseKernelRequested.exchange(false) || kernelDesignPending || kernelLength != designedKernelLength);
+
+	if (!anyChanged)
+	{
+		if (kernelOutdated)
+			designLinearPhaseKernel(designedCoefficients, hostSampleRate, sampleRate, kernelLength);
+
+		return false;
+	}
+
 	auto chainSettings = getChainSettings(apvts);
+	auto& designed = designedCoefficients;
+
+	if (changed[ChainPositions::LowCut])
+	{
+		designed.settings.lowCutFreq = chainSettings.lowCutFreq;
+		designed.settings.lowCutSlope = chainSettings.lowCutSlope;
+		designed.settings.lowCutBypassed = chainSettings.lowCutBypassed;
+		coefficientCache->getLowCutFilter(designed.lowCut, chainSettings, sampleRate);
+	}
+
+	if (changed[ChainPositions::Peak])
+	{
+		designed.settings.peakFreq = chainSettings.peakFreq;
+		designed.settings.peakGainInDecibels = chainSettings.peakGainInDecibels;
+		designed.settings.peakQuality = chainSettings.peakQuality;
+		designed.settings.peakBypassed = chainSettings.peakBypassed;
+		coefficientCache->getPeakFilter(designed.peak, chainSettings, sampleRate);
+	}
+
+	if (changed[ChainPositions::HighCut])
+	{
+		designed.settings.highCutFreq = chainSettings.highCutFreq;
+		designed.settings.highCutSlope = chainSettings.highCutSlope;
+		designed.settings.highCutBypassed = chainSettings.highCutBypassed;
+		coefficientCache->getHighCutFilter(designed.highCut, chainSettings, sampleRate);
+	}
+
+	designed.oversamplingFactor = oversamplingFactor;
+	designedOversamplingFactor.store(oversamplingFactor);
+
+	designed.tailSamples = (estimateTailSamples(designed, sampleRate) + oversamplingFactor - 1) / oversamplingFactor;
+	tailLengthSeconds.store(designed.tailSamples / hostSampleRate);
+
+	publishedCoefficients.getWriteSlot() = designed;
+	publishedCoefficients.publish();
+
+	if (kernelLength > 0)
+		designLinearPhaseKernel(designed, hostSampleRate, sampleRate, kernelLength);
+
+	return true;
+}
+
+//The kernel is built from the very sections the biquads run, so both modes have the same magnitude response
+void AudioPlugin_TestAudioProcessor::designLinearPhaseKernel(const ChainCoefficients& chainCoefficients, double hostSampleRate, double sampleRate, int length)
+{
+	std::array<BiquadCoeffs, 2 * CutCoeffs::maxNumStages + 1> sections;
+	auto numSections = 0;
+
+	auto addCut = [&sections, &numSections](const CutCoeffs& cut)
+	{
+		for (int i = 0; i < cut.numStages; ++i)
+			sections[(size_t)numSections++] = cut.stages[(size_t)i];
+	};
+
+	const auto& settings = chainCoefficients.settings;
+	if (!settings.lowCutBypassed)
+		addCut(chainCoefficients.lowCut);
+	if (!settings.peakBypassed)
+		sections[(size_t)numSections++] = chainCoefficients.peak;
+	if (!settings.highCutBypassed)
+		addCut(chainCoefficients.highCut);
+
+	//Fails while the audio thread is still crossfading, the next pass tries again
+	kernelDesignPending = !linearPhase.designKernel(sections.data(), numSections, hostSampleRate, sampleRate, length);
+	designedKernelLength = length;
+
+	//The convolver rings for the whole kernel, plus the partition still on its way through
+	auto kernelTailSamples = length + LinearPhaseEqualizer::partitionSize;
+	tailLengthSeconds.store(juce::jmax(chainCoefficients.tailSamples, kernelTailSamples) / hostSampleRate);
+}
+
+int AudioPlugin_TestAudioProcessor::getLinearPhaseLengthToDesign() const
+{
+	if (phaseModeChoice->load() < 0.5f)
+		return 0;
+
+	return 2048 << juce::jlimit(0, 3, (int)linearPhaseLengthChoice->load());
+}
+
+//Offline bounces can take their time, so they always get the most accurate filters
+int AudioPlugin_TestAudioProcessor::getOversamplingFactorToDesign() const
+{
+	if (preparedNonRealtime.load())
+		return maxOversamplingFactor;
+
+	return 1 << juce::jlimit(0, 2, (int)oversamplingChoice->load());
+}
+
+//Audio thread. The host can only be told from the message thread, and posting a message
+//from here could block, so this just leaves the value for timerCallback
+void AudioPlugin_TestAudioProcessor::reportLatency(int latencySamples)
+{
+	if (latencySamples == reportedLatency)
+		return;
+
+	reportedLatency = latencySamples;
+	pendingLatencySamples.store(latencySamples);
+}
+
+//Message thread, polls for an oversampling factor or phase mode switch on the audio thread
+void AudioPlugin_TestAudioProcessor::timerCallback()
+{
+	auto latencySamples = pendingLatencySamples.load();
+	if (latencySamples != getLatencySamples())
+		setLatencySamples(latencySamples);
+
+	//The tail follows every redesign, hosts only ask for it again when told something changed
+	auto tail = tailLengthSeconds.load();
+	if (tail != reportedTailLengthSeconds)
+	{
+		reportedTailLengthSeconds = tail;
+		updateHostDisplay();
+	}
+}
+
+int AudioPlugin_TestAudioProcessor::getProcessingLatency() const
+{
+	return linearPhaseActive ? linearPhase.getLatencySamples() : oversamplingLatency;
+}
+
+//Audio thread, once per block
+void AudioPlugin_TestAudioProcessor::updateLinearPhase()
+{
+	auto linearSelected = phaseModeChoice->load() > 0.5f;
+
+	//The kernel stops following the parameters in minimum phase mode, so it mustn't come back stale.
+	//Ask for a fresh one instead
+	if (!linearSelected && linearPhase.hasKernel())
+	{
+		linearPhase.releaseKernel();
+		linearPhaseKernelRequested.store(true);
+	}
+
+	auto latencyChanged = linearSelected && linearPhase.updateKernel();
+
+	//Linear phase only takes over once its first kernel is there
+	auto useLinearPhase = linearSelected && linearPhase.hasKernel();
+
+	if (useLinearPhase != linearPhaseActive || latencyChanged)
+	{
+		//Whichever path takes over starts from a cleared state, like a processing mode switch
+		resetFilterState();
+		linearPhaseActive = useLinearPhase;
+		reportLatency(getProcessingLatency());
+	}
+}
+
+//The sections of a cascade ring one after the other, so summing their decay times is a safe upper bound
+int AudioPlugin_TestAudioProcessor::estimateTailSamples(const ChainCoefficients& chainCoefficients, double sampleRate)
+{
+	constexpr double decayDecibels = 120.0;
+	const auto& settings = chainCoefficients.settings;
+	auto samples = 0.0;
+
+	auto addCut = [&samples](const CutCoeffs& cut)
+	{
+		for (int i = 0; i < cut.numStages; ++i)
+			samples += getDecaySamples(cut.stages[(size_t)i], decayDecibels);
+	};
+
+	if (!settings.lowCutBypassed)
+		addCut(chainCoefficients.lowCut);
+	if (!settings.peakBypassed)
+		samples += getDecaySamples(chainCoefficients.peak, decayDecibels);
+	if (!settings.highCutBypassed)
+		addCut(chainCoefficients.highCut);
+
+	//Unstable or nearly unstable designs would never go to sleep, cap them
+	return (int)std::ceil(juce::jmin(samples, maxTailSeconds * sampleRate));
+}
+
+void AudioPlugin_TestAudioProcessor::resetFilterState()
+{
+	withActiveEngines([](auto& engines)
+	{
+		for (auto* chain : engines.channelChains)
+			chain->reset();
+
+		engines.simdChain.reset();
+
+		for (auto& oversampler : engines.oversamplers)
+			if (oversampler != nullptr)
+				oversampler->reset();
+	});
+
+	linearPhase.reset();
+}
+
+//The coefficients are designed once and copied into every channel's chain, a few floats (or doubles) per filter
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::updatePeakFilter(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients)
+{
+	for (auto* chain : engines.channelChains)
+	{
+		chain->template setBypassed<ChainPositions::Peak>(chainCoefficients.settings.peakBypassed);
+		updateCoefficients(chain->template get<ChainPositions::Peak>(), chainCoefficients.peak);
+	}
+}
 
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::updateLowCutFilters(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients)
+{
+	//LowCutFilter
+	for (auto* chain : engines.channelChains)
+	{
+		chain->template setBypassed<ChainPositions::LowCut>(chainCoefficients.settings.lowCutBypassed);
+		updateCutFilter(chain->template get<ChainPositions::LowCut>(), chainCoefficients.lowCut);
+	}
+}
+
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::updateHighCutFilters(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients)
+{
+	//HighCutFilter
+	for (auto* chain : engines.channelChains)
+	{
+		chain->template setBypassed<ChainPositions::HighCut>(chainCoefficients.settings.highCutBypassed);
+		updateCutFilter(chain->template get<ChainPositions::HighCut>(), chainCoefficients.highCut);
+	}
+}
+
+template<typename SampleType>
+void AudioPlugin_TestAudioProcessor::updateEngines(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients)
+{
 	//LowCutFilter
-	updateLowCutFilters(chainSettings);
+	updateLowCutFilters(engines, chainCoefficients);
 	//PeakFilter
-	updatePeakFilter(chainSettings);
+	updatePeakFilter(engines, chainCoefficients);
 	//HighCutFilter
-	updateHighCutFilters(chainSettings);
+	updateHighCutFilters(engines, chainCoefficients);
+
+	//The SIMD engine sees the peak as a cascade with a single stage
+	CutCoeffs peak;
+	peak.stages[0] = chainCoefficients.peak;
+
+	const auto& settings = chainCoefficients.settings;
+	engines.simdChain.setBand(ChainPositions::LowCut, chainCoefficients.lowCut, settings.lowCutBypassed);
+	engines.simdChain.setBand(ChainPositions::Peak, peak, settings.peakBypassed);
+	engines.simdChain.setBand(ChainPositions::HighCut, chainCoefficients.highCut, settings.highCutBypassed);
+}
+
+void AudioPlugin_TestAudioProcessor::updateFilters(const ChainCoefficients& chainCoefficients)
+{
+	withActiveEngines([&chainCoefficients](auto& engines) { updateEngines(engines, chainCoefficients); });
+
+	//New rate: the old filter state means nothing at it, and the host has to hear about the new latency
+	if (chainCoefficients.oversamplingFactor != activeOversamplingFactor)
+	{
+		resetFilterState();
+		activeOversamplingFactor = chainCoefficients.oversamplingFactor;
+
+		oversamplingLatency = 0;
+		if (activeOversamplingFactor > 1)
+			withActiveEngines([this](auto& engines)
+			{
+				oversamplingLatency = juce::roundToInt(getOversampler(engines, activeOversamplingFactor).getLatencyInSamples());
+			});
+
+		reportLatency(getProcessingLatency());
+	}
+
+	//The oversampling filters ring too
+	tailSamples = chainCoefficients.tailSamples + oversamplingLatency;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout AudioPlugin_TestAudioProcessor::createParameterLayout()
@@ -363,6 +967,21 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPlugin_TestAudioProcess
 	layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));
 	layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
 
+	//Analyzer resolution, and how many frames overlap (the hop is FFT size / overlap)
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer FFT Size", "Analyzer FFT Size", juce::StringArray{ "2048", "4096", "8192" }, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Overlap", "Analyzer Overlap", juce::StringArray{ "1x", "2x", "4x", "8x" }, 2));
+
+	//Runs the filters at 2x or 4x the host rate, at the cost of the half-band filters' latency
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", juce::StringArray{ "Off", "2x", "4x" }, 0));
+
+	//Left/right or mid/side spectra, both come out of the same transform
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Mode", "Analyzer Mode", juce::StringArray{ "L/R", "M/S" }, 0));
+
+	//Same magnitude response without the phase shift, as an FIR kernel of this many taps.
+	//Longer kernels resolve lower frequencies but add more latency
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Phase Mode", "Phase Mode", juce::StringArray{ "Minimum", "Linear" }, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Linear Phase Length", "Linear Phase Length", juce::StringArray{ "2048", "4096", "8192", "16384" }, 2));
+
 	return layout;
 }
 
@@ -10,30 +10,65 @@
 
 #include <JuceHeader.h>
 #include <array>
+#include <atomic>
+#include "BiquadCascade.h"
+#include "CoefficientCache.h"
+#include "LinearPhaseConvolver.h"
+
+//Single producer / single consumer "latest value" hand-over.
+//The producer fills the back slot and publishes it, the consumer picks up the most recent one.
+//Neither side blocks or allocates, intermediate values may be skipped.
+template<typename T>
+struct TripleBuffer
+{
+    //Producer side
+    T& getWriteSlot() { return slots[backIndex]; }
+
+    void publish()
+    {
+        backIndex = middle.exchange(backIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //Consumer side, returns true if something newer than the current read slot was published
+    bool acquireLatest()
+    {
+        if ((middle.load(std::memory_order_acquire) & newDataFlag) == 0)
+            return false;
+
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getReadSlot() const { return slots[frontIndex]; }
+    T& getReadSlot() { return slots[frontIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataFlag = 4;
+
+    std::array<T, 3> slots;
+    int backIndex = 0, frontIndex = 1;
+    std::atomic<int> middle{ 2 };
+};
 
-//Explained in another tutorial 
+/*
+ Single producer, single consumer queue of preallocated slots.
+ reserveWrite/commitWrite and acquireRead/releaseRead hand out the slots themselves,
+ so producers fill them in place and consumers read (or swap) them in place.
+ push and pull are the copying versions of the same thing.
+ */
 template<typename T>
 struct Fifo
 {
-	void prepare(int numChannels, int numSamples)
+	//An AbstractFifo keeps one slot free, so this holds capacity - 1 items
+	explicit Fifo(int capacity) : buffers((size_t)capacity), fifo(capacity)
 	{
-		static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
-			"prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
-		for (auto& buffer : buffers)
-		{
-			buffer.setSize(numChannels,
-				numSamples,
-				false,   //clear everything?
-				true,    //including the extra space?
-				true);   //avoid reallocating if you can?
-			buffer.clear();
-		}
+		jassert(capacity > 1);
 	}
 
+	//Sizes every slot, for a Fifo of std::vector
 	void prepare(size_t numElements)
 	{
-		static_assert(std::is_same_v<T, std::vector<float>>,
-			"prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
 		for (auto& buffer : buffers)
 		{
 			buffer.clear();
@@ -41,13 +76,33 @@ struct Fifo
 		}
 	}
 
+	//Producer side: the next free slot, or nullptr if the fifo is full. Call commitWrite() when it's filled
+	T* reserveWrite()
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite(1, start1, size1, start2, size2);
+		return size1 > 0 ? &buffers[(size_t)start1] : nullptr;
+	}
+
+	void commitWrite() { fifo.finishedWrite(1); }
+
+	//Consumer side: the oldest filled slot, or nullptr if there is none. Call releaseRead() when done with it
+	T* acquireRead()
+	{
+		int start1, size1, start2, size2;
+		fifo.prepareToRead(1, start1, size1, start2, size2);
+		return size1 > 0 ? &buffers[(size_t)start1] : nullptr;
+	}
+
+	void releaseRead() { fifo.finishedRead(1); }
+
 	//Push stuff 
 	bool push(const T& t)
 	{
-		auto write = fifo.write(1);
-		if (write.blockSize1 > 0)
+		if (auto* slot = reserveWrite())
 		{
-			buffers[write.startIndex1] = t;
+			*slot = t;
+			commitWrite();
 			return true;
 		}
 
@@ -57,10 +112,10 @@ struct Fifo
 	//Pull stuff
 	bool pull(T& t)
 	{
-		auto read = fifo.read(1);
-		if (read.blockSize1 > 0)
+		if (auto* slot = acquireRead())
 		{
-			t = buffers[read.startIndex1];
+			t = *slot;
+			releaseRead();
 			return true;
 		}
 
@@ -72,9 +127,8 @@ struct Fifo
 		return fifo.getNumReady();
 	}
 private:
-	static constexpr int Capacity = 30;
-	std::array<T, Capacity> buffers;
-	juce::AbstractFifo fifo{ Capacity };
+	std::vector<T> buffers;
+	juce::AbstractFifo fifo;
 };
 
 enum Channel
@@ -83,75 +137,121 @@ enum Channel
 	Left //effectively 1
 };
 
-//Explained in another tutorial 
-template<typename BlockType>
+/*
+ Ring buffer between processBlock and the analyzer, for one channel.
+ The audio thread writes whole blocks with at most two copies, and the analyzer copies out
+ whatever window it needs straight from the ring. Positions are absolute sample counts,
+ so the reader can tell when the writer has lapped it (seqlock style) and skip ahead.
+ Nothing allocates after construction.
+ */
 struct SingleChannelSampleFifo
 {
-	SingleChannelSampleFifo(Channel ch) : channelToUse(ch)
+	//Needs to hold the largest FFT window plus the audio that arrives between two analyzer frames
+	static constexpr int capacity = 1 << 15;
+
+	SingleChannelSampleFifo(Channel ch) : channelToUse(ch), ring((size_t)capacity, 0.f)
 	{
 		prepared.set(false);
 	}
 
-	//How do we feed buffer
-	void update(const BlockType& buffer)
+	//How do we feed buffer. Double precision blocks are rounded to float on the way in, the analyzer doesn't need more
+	template<typename SampleType>
+	void update(const juce::AudioBuffer<SampleType>& buffer)
 	{
 		jassert(prepared.get());
-		jassert(buffer.getNumChannels() > channelToUse);
-		auto* channelPtr = buffer.getReadPointer(channelToUse);
+		jassert(buffer.getNumChannels() > 0);
 
-		for (int i = 0; i < buffer.getNumSamples(); ++i)
-		{
-			pushNextSampleIntoFifo(channelPtr[i]);
-		}
+		//Mono layouts feed the same channel to both analyzers
+		auto* channelPtr = buffer.getReadPointer(juce::jmin((int)channelToUse, buffer.getNumChannels() - 1));
+		auto numSamples = buffer.getNumSamples();
+
+		auto endPosition = writePosition.load(std::memory_order_relaxed) + numSamples;
+
+		//Only the newest 'capacity' samples can survive anyway
+		auto numToWrite = juce::jmin(numSamples, capacity);
+		channelPtr += numSamples - numToWrite;
+
+		//Tell readers which positions are about to be overwritten before touching them
+		reservedPosition.store(endPosition, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto index = (int)((endPosition - numToWrite) & (capacity - 1));
+		auto numBeforeWrap = juce::jmin(numToWrite, capacity - index);
+
+		copySamples(ring.data() + index, channelPtr, numBeforeWrap);
+		copySamples(ring.data(), channelPtr + numBeforeWrap, numToWrite - numBeforeWrap);
+
+		writePosition.store(endPosition, std::memory_order_release);
 	}
 
 	//How to prepare buffer
 	void prepare(int bufferSize)
 	{
+		//Positions keep counting across prepares, so a reader never sees them go backwards
 		prepared.set(false);
 		size.set(bufferSize);
-
-		bufferToFill.setSize(1,             //channel
-			bufferSize,    //num samples
-			false,         //keepExistingContent
-			true,          //clear extra space
-			true);         //avoid reallocating
-		audioBufferFifo.prepare(1, bufferSize);
-		fifoIndex = 0;
 		prepared.set(true);
 	}
 
 	//==============================================================================
-	int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
 	bool isPrepared() const { return prepared.get(); }
-	//How many buffers we have 
+	//Block size the processor was prepared with
 	int getSize() const { return size.get(); }
 
-	//==============================================================================
-	//get buffers from it
-	bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
-private:
-	Channel channelToUse;
-	int fifoIndex = 0;
-	Fifo<BlockType> audioBufferFifo;
-	BlockType bufferToFill;
-	juce::Atomic<bool> prepared = false;
-	juce::Atomic<int> size = 0;
+	//Total number of samples written so far
+	juce::int64 getNumSamplesWritten() const { return writePosition.load(std::memory_order_acquire); }
 
-	void pushNextSampleIntoFifo(float sample)
+	//Copies the numSamples samples that end at endPosition.
+	//Returns false if the writer overwrote part of that window while we were reading it
+	bool readWindow(float* destination, int numSamples, juce::int64 endPosition) const
 	{
-		if (fifoIndex == bufferToFill.getNumSamples())
+		jassert(numSamples <= capacity);
+		jassert(endPosition <= getNumSamplesWritten());
+
+		//Before the first sample the analyzer just sees silence
+		auto startPosition = endPosition - numSamples;
+		if (startPosition < 0)
 		{
-			auto ok = audioBufferFifo.push(bufferToFill);
+			auto numZeros = (int)juce::jmin((juce::int64)numSamples, -startPosition);
+			juce::FloatVectorOperations::clear(destination, numZeros);
+			destination += numZeros;
+			numSamples -= numZeros;
+			startPosition = 0;
+		}
 
-			juce::ignoreUnused(ok);
+		auto index = (int)(startPosition & (capacity - 1));
+		auto numBeforeWrap = juce::jmin(numSamples, capacity - index);
 
-			fifoIndex = 0;
-		}
+		juce::FloatVectorOperations::copy(destination, ring.data() + index, numBeforeWrap);
+		juce::FloatVectorOperations::copy(destination + numBeforeWrap, ring.data(), numSamples - numBeforeWrap);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return startPosition >= reservedPosition.load(std::memory_order_relaxed) - capacity;
+	}
+private:
+	static void copySamples(float* destination, const float* source, int numSamples)
+	{
+		juce::FloatVectorOperations::copy(destination, source, numSamples);
+	}
 
-		bufferToFill.setSample(0, fifoIndex, sample);
-		++fifoIndex;
+	static void copySamples(float* destination, const double* source, int numSamples)
+	{
+		for (int i = 0; i < numSamples; ++i)
+			destination[i] = (float)source[i];
 	}
+
+	Channel channelToUse;
+	std::vector<float> ring;
+	std::atomic<juce::int64> writePosition{ 0 }, reservedPosition{ 0 };
+	juce::Atomic<bool> prepared = false;
+	juce::Atomic<int> size = 0;
+};
+
+//How processBlock runs the filters. Both produce the same output within float rounding
+enum class ProcessingMode
+{
+    monoChain,  //One juce::dsp::ProcessorChain per channel, channel after channel
+    simd        //All channels in one pass, one channel per SIMD lane
 };
 
 enum Slope
@@ -175,12 +275,15 @@ struct ChainSettings
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
-//Multiple declaration of filters from DSP module 
-using Filter = juce::dsp::IIR::Filter<float>;//Peak filter -responses of 12db proactive when declared as low db or high
+//Multiple declaration of filters from DSP module, for float or double samples
+template<typename SampleType>
+using Filter = juce::dsp::IIR::Filter<SampleType>;//Peak filter -responses of 12db proactive when declared as low db or high
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;//Different types of filters like High pass,lowpass,peak,shelf,notch,allpass
+template<typename SampleType>
+using CutFilter = juce::dsp::ProcessorChain<Filter<SampleType>, Filter<SampleType>, Filter<SampleType>, Filter<SampleType>>;//Different types of filters like High pass,lowpass,peak,shelf,notch,allpass
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;//MonoChain
+template<typename SampleType>
+using MonoChain = juce::dsp::ProcessorChain<CutFilter<SampleType>, Filter<SampleType>, CutFilter<SampleType>>;//MonoChain
 
 enum ChainPositions
 {
@@ -189,10 +292,30 @@ enum ChainPositions
     HighCut
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);//Helper function to update coefficients
+constexpr int numChainPositions = 3;
+
+//Which band a parameter belongs to, -1 for parameters that don't affect the filters
+int getChainPositionForParameter(const juce::String& parameterID);
+
+template<typename SampleType>
+using Coefficients = typename Filter<SampleType>::CoefficientsPtr;
+
+//Helper function to update coefficients
+template<typename SampleType>
+void updateCoefficients(juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>& old,
+                        const juce::ReferenceCountedObjectPtr<juce::dsp::IIR::Coefficients<SampleType>>& replacements)
+{
+    *old = *replacements;
+}
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+template<typename SampleType>
+Coefficients<SampleType> makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return juce::dsp::IIR::Coefficients<SampleType>::makePeakFilter(sampleRate,
+                                                                    chainSettings.peakFreq,
+                                                                    chainSettings.peakQuality,
+                                                                    juce::Decibels::decibelsToGain((SampleType)chainSettings.peakGainInDecibels));
+}
 
 template<int Index, typename ChainType, typename CoefficientType>
 void update(ChainType& chain, const CoefficientType& coefficient)
@@ -218,19 +341,102 @@ void updateCutFilter(ChainType& chain, const CoefficientType& coefficients, cons
     }
 }
 
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+template<typename SampleType>
+auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
+    return juce::dsp::FilterDesign<SampleType>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate, 2 * (chainSettings.lowCutSlope + 1));
 }
 
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+template<typename SampleType>
+auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
 {
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
+    return juce::dsp::FilterDesign<SampleType>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate, 2 * (chainSettings.highCutSlope + 1));
 }
+
+//==============================================================================
+//Allocation free design path, safe to use on the audio thread
+BiquadCoeffs makeLowPassBiquad(double sampleRate, double frequency, double quality);
+BiquadCoeffs makeHighPassBiquad(double sampleRate, double frequency, double quality);
+BiquadCoeffs makePeakBiquad(double sampleRate, double frequency, double quality, double gainFactor);
+
+//Same Butterworth section split as FilterDesign::designIIR...HighOrderButterworthMethod, written into 'coefficients'
+void designButterworthHighPass(CutCoeffs& coefficients, double frequency, double sampleRate, Slope slope);
+void designButterworthLowPass(CutCoeffs& coefficients, double frequency, double sampleRate, Slope slope);
+
+void designPeakFilter(BiquadCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+void designLowCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+void designHighCutFilter(CutCoeffs& coefficients, const ChainSettings& chainSettings, double sampleRate);
+
+//Gives the filter its own second order coefficient object, call this before prepare() and off the audio thread
+template<typename SampleType>
+void prepareCoefficientStorage(Filter<SampleType>& filter)
+{
+    filter.coefficients = new juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+}
+
+template<typename SampleType>
+void prepareCoefficientStorage(MonoChain<SampleType>& chain)
+{
+    auto prepareCut = [](CutFilter<SampleType>& cut)
+    {
+        prepareCoefficientStorage(cut.template get<0>());
+        prepareCoefficientStorage(cut.template get<1>());
+        prepareCoefficientStorage(cut.template get<2>());
+        prepareCoefficientStorage(cut.template get<3>());
+    };
+
+    prepareCut(chain.template get<ChainPositions::LowCut>());
+    prepareCoefficientStorage(chain.template get<ChainPositions::Peak>());
+    prepareCut(chain.template get<ChainPositions::HighCut>());
+}
+
+//Overwrites the coefficients in place, the filter must have been set up with prepareCoefficientStorage().
+//The design is always done in double, a double filter gets it without rounding
+template<typename SampleType>
+void updateCoefficients(Filter<SampleType>& filter, const BiquadCoeffs& replacements)
+{
+    jassert(filter.coefficients->getFilterOrder() == 2);
+
+    auto* raw = filter.coefficients->getRawCoefficients();
+    raw[0] = (SampleType)replacements.b0;
+    raw[1] = (SampleType)replacements.b1;
+    raw[2] = (SampleType)replacements.b2;
+    raw[3] = (SampleType)replacements.a1;
+    raw[4] = (SampleType)replacements.a2;
+}
+
+template<int Index, typename ChainType>
+void updateCutStage(ChainType& chain, const CutCoeffs& coefficients)
+{
+    auto active = Index < coefficients.numStages;
+    if (active)
+        updateCoefficients(chain.template get<Index>(), coefficients.stages[Index]);
+
+    chain.template setBypassed<Index>(!active);
+}
+
+template<typename ChainType>
+void updateCutFilter(ChainType& chain, const CutCoeffs& coefficients)
+{
+    updateCutStage<0>(chain, coefficients);
+    updateCutStage<1>(chain, coefficients);
+    updateCutStage<2>(chain, coefficients);
+    updateCutStage<3>(chain, coefficients);
+}
+//One background thread per process that designs coefficients for every plugin instance
+struct CoefficientDesignThread : juce::TimeSliceThread
+{
+    CoefficientDesignThread() : juce::TimeSliceThread("Coefficient Design") { startThread(); }
+    ~CoefficientDesignThread() override { stopThread(1000); }
+};
+
 //==============================================================================
 /**
 */
-class AudioPlugin_TestAudioProcessor  : public juce::AudioProcessor
+class AudioPlugin_TestAudioProcessor  : public juce::AudioProcessor,
+                                        private juce::AudioProcessorParameter::Listener,
+                                        private juce::TimeSliceClient,
+                                        private juce::Timer
 {
 public:
     //==============================================================================
@@ -246,6 +452,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    //Hosts with a 64 bit mix engine can hand us their buffers without converting them
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -274,18 +484,192 @@ public:
 
     juce::AudioProcessorValueTreeState apvts{ *this,nullptr,"Parameters", createParameterLayout() };
 
-	using BlockType = juce::AudioBuffer<float>;
-	SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
-	SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
+	SingleChannelSampleFifo leftChannelFifo{ Channel::Left };
+	SingleChannelSampleFifo rightChannelFifo{ Channel::Right };
+
+    //Anything reading the analyzer fifos registers itself, processBlock only feeds them while
+    //someone is registered and "Analyzer Enabled" is on. Safe to call from any thread
+    void addAnalyzerConsumer() { numAnalyzerConsumers.fetch_add(1); }
+    void removeAnalyzerConsumer() { numAnalyzerConsumers.fetch_sub(1); }
+
+    //Can be changed at any time, the newly selected engine starts from a cleared filter state
+    void setProcessingMode(ProcessingMode newMode) { processingMode.store(newMode); }
+    ProcessingMode getProcessingMode() const { return processingMode.load(); }
+    //Enough for 7.1.4 and 9.1.6 beds
+    static constexpr int maxNumChannels = 16;
+
+    //The filters run at getSampleRate() * this, the rate their coefficients are designed for.
+    //"Oversampling" picks it while playing, offline renders always get the highest factor
+    int getOversamplingFactor() const { return designedOversamplingFactor.load(); }
+    static constexpr int maxOversamplingFactor = 4;
+
+    //Which band the parameter at 'parameterIndex' belongs to, -1 for the ones that don't affect the filters.
+    //Worked out once in the constructor, so it's just a lookup from any thread
+    int getChainPositionForParameterIndex(int parameterIndex) const
+    {
+        return juce::isPositiveAndBelow(parameterIndex, (int)parameterChainPositions.size())
+            ? parameterChainPositions[(size_t)parameterIndex]
+            : -1;
+    }
 private:
-    MonoChain leftChain, rightChain;// We need 2 instance of monochain if we want  to do stereo processing 
+    //Both filter engines for one sample type
+    template<typename SampleType>
+    struct ChainEngines
+    {
+        //One MonoChain per channel, grown in prepareToPlay and never touched by the allocator in processBlock
+        juce::OwnedArray<MonoChain<SampleType>> channelChains;
+
+        //Same filters as channelChains, but every channel in one go
+        CascadeChainProcessor<juce::dsp::SIMDRegister<SampleType>> simdChain;
+
+        //Polyphase half-band IIR up/down samplers for 2x and 4x, built for numOversamplerChannels channels
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 2> oversamplers;
+        int numOversamplerChannels = 0;
+    };
+
+    //Only the one for the precision prepareToPlay saw is allocated, the other stays empty
+    ChainEngines<float> floatEngines;
+    ChainEngines<double> doubleEngines;
+    bool preparedDoublePrecision = false;
+
+    template<typename SampleType>
+    void prepareEngines(ChainEngines<SampleType>& engines, double sampleRate, int samplesPerBlock, int numChannels);
+    template<typename SampleType>
+    static void releaseEngines(ChainEngines<SampleType>& engines);
+
+    //Calls 'function' with the engines of the prepared precision
+    template<typename Function>
+    void withActiveEngines(Function&& function)
+    {
+        if (preparedDoublePrecision)
+            function(doubleEngines);
+        else
+            function(floatEngines);
+    }
+
+    //What both processBlock overloads run
+    template<typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer, ChainEngines<SampleType>& engines);
+
+    //Runs the filters over 'block', at whatever rate it's at
+    template<typename SampleType>
+    static void processFilters(juce::dsp::AudioBlock<SampleType> block, ChainEngines<SampleType>& engines, ProcessingMode mode);
 
-    // This is were we take the value from slide and update the filter with given value
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
+    //Oversampler for a factor of 2 or 4
+    template<typename SampleType>
+    static juce::dsp::Oversampling<SampleType>& getOversampler(ChainEngines<SampleType>& engines, int factor);
 
-    void updateFilters();//Update all the filters
+    std::atomic<ProcessingMode> processingMode{ ProcessingMode::simd };
+
+    std::atomic<int> numAnalyzerConsumers{ 0 };
+    std::atomic<float>* analyzerEnabled = nullptr;
+    bool shouldFeedAnalyzer() const;
+    ProcessingMode activeProcessingMode{ ProcessingMode::simd };
+
+    //Everything the audio thread needs to reconfigure the chains, designed off the audio thread.
+    //Plain data, so handing it over and applying it never touches the allocator
+    struct ChainCoefficients
+    {
+        ChainSettings settings;
+        BiquadCoeffs peak;
+        CutCoeffs lowCut, highCut;
+
+        //The filters were designed for the host rate times this
+        int oversamplingFactor{ 1 };
+
+        //How long the active filters ring after the input goes silent, at the host rate
+        int tailSamples{ 0 };
+    };
+
+    TripleBuffer<ChainCoefficients> publishedCoefficients;
+
+    //Bumped by parameterValueChanged for the band the parameter belongs to
+    std::array<std::atomic<juce::uint32>, numChainPositions> bandVersions{};
+    std::vector<int> parameterChainPositions;
+
+    //Designer side state, only touched with designLock held
+    juce::CriticalSection designLock;
+    ChainCoefficients designedCoefficients;
+    std::array<juce::uint32, numChainPositions> designedBandVersions{};
+    double designedSampleRate = 0.0;
+
+    std::atomic<double> designSampleRate{ 0.0 };
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+    double reportedTailLengthSeconds = 0.0; //message thread
+
+    std::atomic<float>* oversamplingChoice = nullptr;
+    std::atomic<int> designedOversamplingFactor{ 1 };
+    int getOversamplingFactorToDesign() const;
+
+    //isNonRealtime() as of the last prepareToPlay. Some hosts flip offline mode without preparing again,
+    //following it live would change the factor, and with it the latency, halfway through a render
+    std::atomic<bool> preparedNonRealtime{ false };
+
+    //Audio thread side of the oversampling switch. The latency it adds is left in pendingLatencySamples,
+    //the message thread timer picks it up from there and tells the host
+    int activeOversamplingFactor = 1;
+    int oversamplingLatency = 0;
+    std::atomic<int> pendingLatencySamples{ 0 };
+    int reportedLatency = 0;
+    void reportLatency(int latencySamples);
+
+    static constexpr int hostNotificationIntervalMs = 50;
+    void timerCallback() override;
+
+    //"Phase Mode" Linear runs an FIR with the chain's magnitude response instead of the biquads, at the cost of
+    //half the kernel ("Linear Phase Length") plus one partition of latency. Kernels are designed with the coefficients
+    LinearPhaseEqualizer linearPhase;
+    std::atomic<float>* phaseModeChoice = nullptr;
+    std::atomic<float>* linearPhaseLengthChoice = nullptr;
+    std::atomic<bool> linearPhaseKernelRequested{ false }; //set by the audio thread after dropping its kernel
+    int getLinearPhaseLengthToDesign() const; //0 in minimum phase mode
+
+    //Designer side, with designLock held
+    int designedKernelLength = 0;
+    bool kernelDesignPending = false;
+    void designLinearPhaseKernel(const ChainCoefficients& chainCoefficients, double hostSampleRate, double sampleRate, int length);
+
+    //Audio thread: switches to the convolver once it has a kernel, and back
+    bool linearPhaseActive = false;
+    void updateLinearPhase();
+    int getProcessingLatency() const;
+
+    //Silence detection, audio thread only. Once the input has been all zeros for longer
+    //than the tail and the output died away below silenceThreshold, the filters are flushed and DSP is skipped
+    static constexpr float silenceThreshold = 1.0e-6f; //-120 dB
+    static constexpr double maxTailSeconds = 10.0;
+    int tailSamples = 0;
+    juce::int64 silentSamples = 0;
+    bool dspSleeping = false;
+
+    static int estimateTailSamples(const ChainCoefficients& chainCoefficients, double sampleRate);
+    void resetFilterState();
+
+    juce::SharedResourcePointer<CoefficientDesignThread> designThread;
+    juce::SharedResourcePointer<CoefficientCache> coefficientCache;
+    static constexpr int designPollIntervalMs = 5;
+
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { }
+
+    int useTimeSlice() override;
+
+    void markAllBandsChanged();
+
+    //Redesigns the bands whose parameters moved and publishes the result, returns false if nothing changed
+    bool designChainCoefficients();
+
+    // This is were we take the designed coefficients and update the filters with them
+    template<typename SampleType>
+    static void updatePeakFilter(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients);
+    template<typename SampleType>
+    static void updateLowCutFilters(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients);
+    template<typename SampleType>
+    static void updateHighCutFilters(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients);
+    template<typename SampleType>
+    static void updateEngines(ChainEngines<SampleType>& engines, const ChainCoefficients& chainCoefficients);
+
+    void updateFilters(const ChainCoefficients& chainCoefficients);//Update all the filters
 
 	//Produce a sin wave and then aling with a particular freq
 	juce::dsp::Oscillator<float> osc;
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    Turns FFT magnitudes into the decibel values the analyzer draws.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstring>
+#include <limits>
+
+enum class SpectrumPostProcessing
+{
+    reference, //juce::Decibels per bin, kept to check the fast version against
+    fast       //fused normalise and log2 approximation, vectorised where we can
+};
+
+namespace SpectrumKernels
+{
+//log2(1 + t) for t in [0, 1), exact at both ends so neighbouring octaves join up.
+//Worst case error is about 0.001 dB once scaled to decibels
+constexpr float log2Coefficients[] = { 1.43894844f, -0.677150764f, 0.318213221f, -0.0800108969f };
+
+//20 * log10(2)
+constexpr float decibelsPerOctave = 6.02059991f;
+
+//What the analyzer always did: scale every bin, zero NaN and inf, then Decibels::gainToDecibels
+inline void magnitudesToDecibelsReference(float* data, int numBins, float scale, float negativeInfinity)
+{
+    for (int i = 0; i < numBins; ++i)
+    {
+        auto v = data[i];
+        v = (!std::isinf(v) && !std::isnan(v)) ? v * scale : 0.f;
+        data[i] = juce::Decibels::gainToDecibels(v, negativeInfinity);
+    }
+}
+
+inline float magnitudeToDecibels(float magnitude, float scale, float floorGain, float negativeInfinity)
+{
+    auto x = magnitude * scale;
+
+    //NaN and inf count as silence, like the reference
+    x = x < std::numeric_limits<float>::infinity() ? x : 0.f;
+    x = juce::jmax(x, floorGain);
+
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    auto exponent = (float)((int)(bits >> 23) - 127);
+    auto mantissaBits = (bits & 0x007fffffu) | 0x3f800000u;
+
+    float t;
+    std::memcpy(&t, &mantissaBits, sizeof(t));
+    t -= 1.f;
+
+    auto log2 = exponent + t * (log2Coefficients[0] + t * (log2Coefficients[1] + t * (log2Coefficients[2] + t * log2Coefficients[3])));
+    return juce::jmax(log2 * decibelsPerOctave, negativeInfinity);
+}
+
+//Same result as the reference to within the approximation, in one pass over the bins
+inline void magnitudesToDecibels(float* data, int numBins, float scale, float negativeInfinity)
+{
+    //Anything quieter than this comes out as negativeInfinity anyway, clamping here keeps the bit tricks away from zero and denormals
+    const auto floorGain = std::pow(10.f, negativeInfinity * 0.05f);
+    jassert(floorGain >= std::numeric_limits<float>::min());
+
+    int i = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    const auto scaleV = _mm_set1_ps(scale);
+    const auto infV = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const auto floorV = _mm_set1_ps(floorGain);
+    const auto negativeInfinityV = _mm_set1_ps(negativeInfinity);
+    const auto oneV = _mm_set1_ps(1.f);
+    const auto decibelsV = _mm_set1_ps(decibelsPerOctave);
+    const auto mantissaMask = _mm_set1_epi32(0x007fffff);
+    const auto oneBits = _mm_set1_epi32(0x3f800000);
+    const auto bias = _mm_set1_epi32(127);
+    const auto c0 = _mm_set1_ps(log2Coefficients[0]), c1 = _mm_set1_ps(log2Coefficients[1]);
+    const auto c2 = _mm_set1_ps(log2Coefficients[2]), c3 = _mm_set1_ps(log2Coefficients[3]);
+
+    for (; i + 4 <= numBins; i += 4)
+    {
+        auto x = _mm_mul_ps(_mm_loadu_ps(data + i), scaleV);
+        x = _mm_and_ps(x, _mm_cmplt_ps(x, infV)); //false for NaN too
+        x = _mm_max_ps(x, floorV);
+
+        auto bits = _mm_castps_si128(x);
+        auto exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+        auto t = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), oneBits)), oneV);
+
+        auto poly = _mm_add_ps(c2, _mm_mul_ps(t, c3));
+        poly = _mm_add_ps(c1, _mm_mul_ps(t, poly));
+        poly = _mm_add_ps(c0, _mm_mul_ps(t, poly));
+        poly = _mm_mul_ps(t, poly);
+
+        auto decibels = _mm_mul_ps(_mm_add_ps(exponent, poly), decibelsV);
+        _mm_storeu_ps(data + i, _mm_max_ps(decibels, negativeInfinityV));
+    }
+   #elif JUCE_USE_ARM_NEON
+    const auto scaleV = vdupq_n_f32(scale);
+    const auto infV = vdupq_n_f32(std::numeric_limits<float>::infinity());
+    const auto floorV = vdupq_n_f32(floorGain);
+    const auto negativeInfinityV = vdupq_n_f32(negativeInfinity);
+    const auto oneV = vdupq_n_f32(1.f);
+    const auto decibelsV = vdupq_n_f32(decibelsPerOctave);
+    const auto mantissaMask = vdupq_n_u32(0x007fffff);
+    const auto oneBits = vdupq_n_u32(0x3f800000);
+    const auto bias = vdupq_n_s32(127);
+    const auto c0 = vdupq_n_f32(log2Coefficients[0]), c1 = vdupq_n_f32(log2Coefficients[1]);
+    const auto c2 = vdupq_n_f32(log2Coefficients[2]), c3 = vdupq_n_f32(log2Coefficients[3]);
+
+    for (; i + 4 <= numBins; i += 4)
+    {
+        auto x = vmulq_f32(vld1q_f32(data + i), scaleV);
+        x = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), vcltq_f32(x, infV))); //false for NaN too
+        x = vmaxq_f32(x, floorV);
+
+        auto bits = vreinterpretq_u32_f32(x);
+        auto exponent = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), bias));
+        auto t = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, mantissaMask), oneBits)), oneV);
+
+        auto poly = vmlaq_f32(c2, t, c3);
+        poly = vmlaq_f32(c1, t, poly);
+        poly = vmlaq_f32(c0, t, poly);
+        poly = vmulq_f32(t, poly);
+
+        auto decibels = vmulq_f32(vaddq_f32(exponent, poly), decibelsV);
+        vst1q_f32(data + i, vmaxq_f32(decibels, negativeInfinityV));
+    }
+   #endif
+
+    for (; i < numBins; ++i)
+        data[i] = magnitudeToDecibels(data[i], scale, floorGain, negativeInfinity);
+}
+}
@@ -0,0 +1,295 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer: streams audio files through
+    AudioPlugin_TestAudioProcessor without a host.
+
+    BatchRenderer --preset <file> --output <dir> [--block-size <n>] [--threads <n>] <input files...>
+
+    The preset is the binary state written by getStateInformation.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <set>
+#include "../../../Source/PluginProcessor.h"
+
+namespace
+{
+struct Options
+{
+    juce::File preset, outputDirectory;
+    int blockSize = 8192;
+    int numThreads = juce::SystemStats::getNumCpuCores();
+    juce::Array<juce::File> inputs;
+};
+
+void printUsage()
+{
+    std::cout << "Usage: BatchRenderer --preset <file> --output <dir> [--block-size <n>] [--threads <n>] <input files...>" << std::endl;
+}
+
+bool parseArguments(const juce::StringArray& args, Options& options)
+{
+    for (int i = 0; i < args.size(); ++i)
+    {
+        auto arg = args[i];
+        auto hasValue = i + 1 < args.size();
+
+        if (arg == "--preset" && hasValue)
+            options.preset = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--output" && hasValue)
+            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--block-size" && hasValue)
+            options.blockSize = args[++i].getIntValue();
+        else if (arg == "--threads" && hasValue)
+            options.numThreads = args[++i].getIntValue();
+        else if (arg.startsWith("-"))
+            return false;
+        else
+            options.inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+    }
+
+    return options.preset.existsAsFile()
+        && options.outputDirectory != juce::File()
+        && options.blockSize > 0
+        && options.numThreads > 0
+        && !options.inputs.isEmpty();
+}
+
+//Every output goes straight into --output under the input's file name, so two inputs with the same
+//name would have two workers writing one file. Returns the first name that's used twice.
+//Compared ignoring case, which is how the file systems on Windows and macOS see it
+juce::String findDuplicateOutputName(const Options& options)
+{
+    std::set<juce::String> names;
+
+    for (const auto& input : options.inputs)
+    {
+        auto name = input.getFileName();
+        if (!names.insert(name.toLowerCase()).second)
+            return name;
+    }
+
+    return {};
+}
+
+//Renders one file with a processor that only this thread uses
+bool renderFile(AudioPlugin_TestAudioProcessor& processor,
+                juce::AudioFormatManager& formatManager,
+                const juce::File& input,
+                const juce::File& output,
+                int blockSize,
+                juce::String& error)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+    if (reader == nullptr)
+    {
+        error = "unsupported or unreadable file";
+        return false;
+    }
+
+    auto numChannels = (int)reader->numChannels;
+    auto sampleRate = reader->sampleRate;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+    layout.outputBuses.add(juce::AudioChannelSet::canonicalChannelSet(numChannels));
+
+    if (!processor.setBusesLayout(layout))
+    {
+        error = juce::String(numChannels) + " channels aren't supported";
+        return false;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+    if (format == nullptr)
+    {
+        error = "no writer for " + output.getFileExtension();
+        return false;
+    }
+
+    auto bitsPerSample = (int)reader->bitsPerSample;
+    if (!format->getPossibleBitDepths().contains(bitsPerSample))
+        bitsPerSample = 24;
+
+    output.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(output);
+    if (!stream->openedOk())
+    {
+        error = "can't write " + output.getFullPathName();
+        return false;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(),
+                                                                            sampleRate,
+                                                                            (unsigned int)numChannels,
+                                                                            bitsPerSample,
+                                                                            reader->metadataValues,
+                                                                            0));
+    if (writer == nullptr)
+    {
+        error = "can't create a writer for " + output.getFileName();
+        return false;
+    }
+
+    stream.release(); //the writer owns the stream now
+
+    //Offline: the processor designs coefficients inline instead of waiting for its design thread,
+    //and oversamples at the highest factor
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    //Run 'latency' samples of silence past the end and drop as many from the start, so the output lines up with the input
+    auto latency = (juce::int64)processor.getLatencySamples();
+    auto numSamplesToProcess = reader->lengthInSamples + latency;
+
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+
+    for (juce::int64 position = 0; position < numSamplesToProcess; position += blockSize)
+    {
+        auto numSamples = (int)juce::jmin((juce::int64)blockSize, numSamplesToProcess - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+
+        //Reading past the end of the file fills the buffer with silence
+        reader->read(&buffer, 0, numSamples, position, true, true);
+        processor.processBlock(buffer, midi);
+
+        auto numToSkip = (int)juce::jlimit((juce::int64)0, (juce::int64)numSamples, latency - position);
+        if (numToSkip == numSamples)
+            continue;
+
+        if (!writer->writeFromAudioSampleBuffer(buffer, numToSkip, numSamples - numToSkip))
+        {
+            processor.releaseResources();
+            error = "write failed";
+            return false;
+        }
+    }
+
+    processor.releaseResources();
+    return true;
+}
+
+struct SharedQueue
+{
+    const Options& options;
+    std::atomic<int> nextInput{ 0 };
+    std::atomic<int> numFailed{ 0 };
+    juce::CriticalSection outputLock;
+};
+
+//Pulls files off the shared queue until it's empty, with its own processor instance
+struct RenderWorker : juce::Thread
+{
+    RenderWorker(int index, SharedQueue& q, std::unique_ptr<AudioPlugin_TestAudioProcessor> p)
+        : juce::Thread("Render Worker " + juce::String(index)), queue(q), processor(std::move(p))
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    void run() override
+    {
+        const auto& inputs = queue.options.inputs;
+
+        while (!threadShouldExit())
+        {
+            auto index = queue.nextInput.fetch_add(1);
+            if (index >= inputs.size())
+                break;
+
+            auto input = inputs.getReference(index);
+            auto output = queue.options.outputDirectory.getChildFile(input.getFileName());
+
+            juce::String error;
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            auto ok = output != input && renderFile(*processor, formatManager, input, output, queue.options.blockSize, error);
+            auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+            if (!ok && error.isEmpty())
+                error = "output would overwrite the input";
+
+            if (!ok)
+                ++queue.numFailed;
+
+            const juce::ScopedLock sl(queue.outputLock);
+            if (ok)
+                std::cout << "[ok]     " << input.getFullPathName() << " (" << juce::String(seconds, 2) << " s)" << std::endl;
+            else
+                std::cout << "[failed] " << input.getFullPathName() << ": " << error << std::endl;
+        }
+    }
+
+    SharedQueue& queue;
+    std::unique_ptr<AudioPlugin_TestAudioProcessor> processor;
+    juce::AudioFormatManager formatManager;
+};
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    //The processor's parameter state relies on a MessageManager existing
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(juce::String::fromUTF8(argv[i]));
+
+    Options options;
+    if (!parseArguments(args, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    auto duplicateName = findDuplicateOutputName(options);
+    if (duplicateName.isNotEmpty())
+    {
+        std::cout << "More than one input is called " << duplicateName << ", their outputs would overwrite each other" << std::endl;
+        return 1;
+    }
+
+    juce::MemoryBlock preset;
+    if (!options.preset.loadFileAsData(preset))
+    {
+        std::cout << "Can't read preset " << options.preset.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (!options.outputDirectory.createDirectory())
+    {
+        std::cout << "Can't create " << options.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    SharedQueue queue{ options };
+    auto numWorkers = juce::jmin(options.numThreads, options.inputs.size());
+
+    //Processors are created and loaded here on the message thread, then each one is handed to its worker
+    juce::OwnedArray<RenderWorker> workers;
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto processor = std::make_unique<AudioPlugin_TestAudioProcessor>();
+        processor->setStateInformation(preset.getData(), (int)preset.getSize());
+        workers.add(new RenderWorker(i, queue, std::move(processor)));
+    }
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit(-1);
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+    std::cout << options.inputs.size() << " files, " << queue.numFailed.load() << " failed, "
+              << juce::String(seconds, 2) << " s on " << numWorkers << " threads" << std::endl;
+
+    return queue.numFailed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,540 @@
+/*
+  ==============================================================================
+
+    processBlock micro-benchmarks for AudioPlugin_TestAudioProcessor.
+
+    Benchmark [--json <file>] [--quick]
+
+    Sweeps sample precision, block size, sample rate, cut filter slope, bypass state
+    and processing mode, and reports ns/sample percentiles per configuration.
+    The JSON output has one record per configuration, so two releases can be diffed.
+
+    Also checks the SIMD engine against the MonoChain it replaces and exits with 1
+    if they differ by more than rounding.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <iostream>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/SpectrumKernels.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+struct Stats
+{
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0;
+};
+
+Stats getStats(std::vector<double>& values)
+{
+    Stats stats;
+    if (values.empty())
+        return stats;
+
+    std::sort(values.begin(), values.end());
+
+    auto percentile = [&values](double p)
+    {
+        auto index = (size_t)juce::jlimit(0.0, (double)values.size() - 1.0, std::ceil(p * (double)values.size()) - 1.0);
+        return values[index];
+    };
+
+    for (auto v : values)
+        stats.mean += v;
+
+    stats.mean /= (double)values.size();
+    stats.p50 = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    stats.p99 = percentile(0.99);
+    return stats;
+}
+
+template<typename Function>
+Stats measure(int numRuns, int samplesPerRun, Function&& function)
+{
+    std::vector<double> nsPerSample;
+    nsPerSample.reserve((size_t)numRuns);
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+        auto start = Clock::now();
+        function();
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        nsPerSample.push_back(elapsed / samplesPerRun);
+    }
+
+    return getStats(nsPerSample);
+}
+
+void setParameter(AudioPlugin_TestAudioProcessor& processor, const juce::String& id, float value)
+{
+    auto* param = processor.apvts.getParameter(id);
+    jassert(param != nullptr);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+enum class Bypass
+{
+    none,
+    lowCut,
+    peak,
+    highCut
+};
+
+const char* getName(Bypass bypass)
+{
+    switch (bypass)
+    {
+    case Bypass::lowCut: return "lowCut";
+    case Bypass::peak: return "peak";
+    case Bypass::highCut: return "highCut";
+    case Bypass::none: break;
+    }
+
+    return "none";
+}
+
+const char* getName(ProcessingMode mode)
+{
+    return mode == ProcessingMode::simd ? "simd" : "monoChain";
+}
+
+//A typical mastering setup, so every band does real work
+void configure(AudioPlugin_TestAudioProcessor& processor, Slope slope, Bypass bypass)
+{
+    setParameter(processor, "LowCut Freq", 40.f);
+    setParameter(processor, "HighCut Freq", 16000.f);
+    setParameter(processor, "Peak Freq", 2500.f);
+    setParameter(processor, "Peak Gain", 3.f);
+    setParameter(processor, "Peak Quality", 0.7f);
+    setParameter(processor, "LowCut Slope", (float)slope);
+    setParameter(processor, "HighCut Slope", (float)slope);
+    setParameter(processor, "LowCut Bypassed", bypass == Bypass::lowCut ? 1.f : 0.f);
+    setParameter(processor, "Peak Bypassed", bypass == Bypass::peak ? 1.f : 0.f);
+    setParameter(processor, "HighCut Bypassed", bypass == Bypass::highCut ? 1.f : 0.f);
+}
+
+juce::var toVar(const Stats& stats)
+{
+    auto* object = new juce::DynamicObject();
+    object->setProperty("mean", stats.mean);
+    object->setProperty("p50", stats.p50);
+    object->setProperty("p90", stats.p90);
+    object->setProperty("p99", stats.p99);
+    return juce::var(object);
+}
+
+template<typename SampleType>
+void fillWithNoise(juce::AudioBuffer<SampleType>& buffer)
+{
+    juce::Random random(1234);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            buffer.setSample(channel, i, (SampleType)(random.nextFloat() * 2.f - 1.f));
+}
+
+const char* getName(juce::AudioProcessor::ProcessingPrecision precision)
+{
+    return precision == juce::AudioProcessor::doublePrecision ? "double" : "float";
+}
+
+//Times processBlock on copies of the same noise, the processor has to be prepared already
+template<typename SampleType>
+Stats measureProcessBlock(AudioPlugin_TestAudioProcessor& processor, int numChannels, int blockSize, int numRuns)
+{
+    juce::AudioBuffer<SampleType> source(numChannels, blockSize), buffer(numChannels, blockSize);
+    fillWithNoise(source);
+
+    juce::MidiBuffer midi;
+
+    //Warm up caches and the branch predictor before timing anything
+    for (int i = 0; i < 16; ++i)
+    {
+        buffer.makeCopyOf(source, true);
+        processor.processBlock(buffer, midi);
+    }
+
+    std::vector<double> nsPerSample;
+    nsPerSample.reserve((size_t)numRuns);
+
+    for (int run = 0; run < numRuns; ++run)
+    {
+        buffer.makeCopyOf(source, true);
+
+        auto start = Clock::now();
+        processor.processBlock(buffer, midi);
+        auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        nsPerSample.push_back(elapsed / blockSize);
+    }
+
+    return getStats(nsPerSample);
+}
+
+//Runs 'input' through one MonoChain per channel and through the SIMD engine, returns the largest difference.
+//Both get the same coefficients straight from the designer, so anything above rounding is a bug in the SIMD path
+template<typename SampleType>
+SampleType compareEngines(const ChainSettings& settings, double sampleRate, int blockSize, const juce::AudioBuffer<SampleType>& input)
+{
+    const auto numChannels = input.getNumChannels();
+    const auto numSamples = input.getNumSamples();
+
+    BiquadCoeffs peak;
+    CutCoeffs lowCut, highCut;
+    designLowCutFilter(lowCut, settings, sampleRate);
+    designPeakFilter(peak, settings, sampleRate);
+    designHighCutFilter(highCut, settings, sampleRate);
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32)blockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = sampleRate;
+
+    juce::OwnedArray<MonoChain<SampleType>> chains;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* chain = chains.add(new MonoChain<SampleType>());
+        prepareCoefficientStorage(*chain);
+        chain->prepare(spec);
+
+        chain->template setBypassed<ChainPositions::LowCut>(settings.lowCutBypassed);
+        chain->template setBypassed<ChainPositions::Peak>(settings.peakBypassed);
+        chain->template setBypassed<ChainPositions::HighCut>(settings.highCutBypassed);
+        updateCutFilter(chain->template get<ChainPositions::LowCut>(), lowCut);
+        updateCoefficients(chain->template get<ChainPositions::Peak>(), peak);
+        updateCutFilter(chain->template get<ChainPositions::HighCut>(), highCut);
+    }
+
+    CutCoeffs peakCascade;
+    peakCascade.stages[0] = peak;
+
+    CascadeChainProcessor<juce::dsp::SIMDRegister<SampleType>> simdChain;
+    simdChain.prepare(numChannels, blockSize);
+    simdChain.setBand(ChainPositions::LowCut, lowCut, settings.lowCutBypassed);
+    simdChain.setBand(ChainPositions::Peak, peakCascade, settings.peakBypassed);
+    simdChain.setBand(ChainPositions::HighCut, highCut, settings.highCutBypassed);
+
+    juce::AudioBuffer<SampleType> reference, simd;
+    reference.makeCopyOf(input);
+    simd.makeCopyOf(input);
+
+    for (int start = 0; start < numSamples; start += blockSize)
+    {
+        auto numToProcess = juce::jmin(blockSize, numSamples - start);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            juce::dsp::AudioBlock<SampleType> block(reference.getArrayOfWritePointers() + channel, 1, (size_t)start, (size_t)numToProcess);
+            juce::dsp::ProcessContextReplacing<SampleType> context(block);
+            chains.getUnchecked(channel)->process(context);
+        }
+
+        std::array<SampleType*, AudioPlugin_TestAudioProcessor::maxNumChannels> channels{};
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[(size_t)channel] = simd.getWritePointer(channel, start);
+
+        simdChain.process(channels.data(), numChannels, numToProcess);
+    }
+
+    auto maxDifference = SampleType(0);
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            maxDifference = juce::jmax(maxDifference, std::abs(simd.getSample(channel, i) - reference.getSample(channel, i)));
+
+    return maxDifference;
+}
+
+//Every slope and bypass combination at every channel count, on an impulse and on noise.
+//Prints the worst case and returns false if it's above 'tolerance'
+template<typename SampleType>
+bool verifySimdEngine(SampleType tolerance, juce::Array<juce::var>& results)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSamples = 4096;
+    constexpr int blockSize = 480; //not a multiple of the register width, and the last block is a partial one
+
+    ChainSettings settings;
+    settings.lowCutFreq = 40.f;
+    settings.highCutFreq = 16000.f;
+    settings.peakFreq = 2500.f;
+    settings.peakGainInDecibels = 3.f;
+    settings.peakQuality = 0.7f;
+
+    auto passed = true;
+
+    for (auto useNoise : { false, true })
+    {
+        auto* input = useNoise ? "noise" : "impulse";
+        auto maxDifference = SampleType(0);
+
+        for (auto slope : { Slope_12, Slope_24, Slope_36, Slope_48 })
+        {
+            for (int bypassed = 0; bypassed < 8; ++bypassed)
+            {
+                settings.lowCutSlope = settings.highCutSlope = slope;
+                settings.lowCutBypassed = (bypassed & 1) != 0;
+                settings.peakBypassed = (bypassed & 2) != 0;
+                settings.highCutBypassed = (bypassed & 4) != 0;
+
+                for (int numChannels = 1; numChannels <= AudioPlugin_TestAudioProcessor::maxNumChannels; ++numChannels)
+                {
+                    juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+
+                    if (useNoise)
+                    {
+                        fillWithNoise(buffer);
+                    }
+                    else
+                    {
+                        buffer.clear();
+                        for (int channel = 0; channel < numChannels; ++channel)
+                            buffer.setSample(channel, 0, SampleType(1));
+                    }
+
+                    maxDifference = juce::jmax(maxDifference, compareEngines(settings, sampleRate, blockSize, buffer));
+                }
+            }
+        }
+
+        auto ok = maxDifference <= tolerance;
+        passed = passed && ok;
+
+        std::cout << "simd vs monoChain, " << (sizeof(SampleType) == sizeof(double) ? "double" : "float") << " " << input
+                  << ": max difference " << juce::String((double)maxDifference, 12) << (ok ? "" : " FAILED") << std::endl;
+
+        auto* record = new juce::DynamicObject();
+        record->setProperty("benchmark", "simdVerification");
+        record->setProperty("precision", sizeof(SampleType) == sizeof(double) ? "double" : "float");
+        record->setProperty("input", input);
+        record->setProperty("maxDifference", (double)maxDifference);
+        record->setProperty("passed", ok);
+        results.add(juce::var(record));
+    }
+
+    return passed;
+}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    //The processor's parameter state relies on a MessageManager existing
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::File jsonFile;
+    auto quick = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+
+        if (arg == "--json" && i + 1 < argc)
+            jsonFile = juce::File::getCurrentWorkingDirectory().getChildFile(juce::String(argv[++i]));
+        else if (arg == "--quick")
+            quick = true;
+        else
+        {
+            std::cout << "Usage: Benchmark [--json <file>] [--quick]" << std::endl;
+            return 1;
+        }
+    }
+
+    const std::vector<int> blockSizes = quick ? std::vector<int>{ 32, 512 }
+                                              : std::vector<int>{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::vector<double> sampleRates = quick ? std::vector<double>{ 48000.0 }
+                                                  : std::vector<double>{ 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 384000.0 };
+    const std::vector<Slope> slopes{ Slope_12, Slope_24, Slope_36, Slope_48 };
+    const std::vector<Bypass> bypassStates{ Bypass::none, Bypass::lowCut, Bypass::peak, Bypass::highCut };
+    const std::vector<ProcessingMode> modes{ ProcessingMode::monoChain, ProcessingMode::simd };
+    const std::vector<juce::AudioProcessor::ProcessingPrecision> precisions{ juce::AudioProcessor::singlePrecision,
+                                                                             juce::AudioProcessor::doublePrecision };
+
+    //Roughly the same amount of audio per configuration, whatever the block size
+    const int samplesPerConfiguration = quick ? 1 << 16 : 1 << 18;
+    const int numChannels = 2;
+
+    AudioPlugin_TestAudioProcessor processor;
+
+    juce::Array<juce::var> results;
+
+    std::cout << "precision mode       block   rate     slope bypass   p50 ns/smp  p90 ns/smp  p99 ns/smp" << std::endl;
+
+    for (auto precision : precisions)
+    {
+        //Has to be set before prepareToPlay, like a host would
+        processor.setProcessingPrecision(precision);
+
+        for (auto mode : modes)
+        {
+            processor.setProcessingMode(mode);
+
+            for (auto sampleRate : sampleRates)
+            {
+                for (auto blockSize : blockSizes)
+                {
+                    auto numRuns = juce::jmax(32, samplesPerConfiguration / blockSize);
+
+                    for (auto slope : slopes)
+                    {
+                        for (auto bypass : bypassStates)
+                        {
+                            configure(processor, slope, bypass);
+                            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                            processor.prepareToPlay(sampleRate, blockSize);
+
+                            auto stats = precision == juce::AudioProcessor::doublePrecision
+                                       ? measureProcessBlock<double>(processor, numChannels, blockSize, numRuns)
+                                       : measureProcessBlock<float>(processor, numChannels, blockSize, numRuns);
+
+                            processor.releaseResources();
+
+                            std::cout << juce::String(getName(precision)).paddedRight(' ', 9) << " "
+                                      << juce::String(getName(mode)).paddedRight(' ', 10) << " "
+                                      << juce::String(blockSize).paddedLeft(' ', 5) << " "
+                                      << juce::String(sampleRate, 0).paddedLeft(' ', 7) << " "
+                                      << juce::String(12 * (slope + 1)).paddedLeft(' ', 5) << " "
+                                      << juce::String(getName(bypass)).paddedRight(' ', 8) << " "
+                                      << juce::String(stats.p50, 3).paddedLeft(' ', 10) << " "
+                                      << juce::String(stats.p90, 3).paddedLeft(' ', 11) << " "
+                                      << juce::String(stats.p99, 3).paddedLeft(' ', 11) << std::endl;
+
+                            auto* record = new juce::DynamicObject();
+                            record->setProperty("benchmark", "processBlock");
+                            record->setProperty("precision", getName(precision));
+                            record->setProperty("mode", getName(mode));
+                            record->setProperty("blockSize", blockSize);
+                            record->setProperty("sampleRate", sampleRate);
+                            record->setProperty("slope", 12 * (slope + 1));
+                            record->setProperty("bypassed", getName(bypass));
+                            record->setProperty("nsPerSample", toVar(stats));
+                            results.add(juce::var(record));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //Back to the default for everything below
+    processor.setProcessingPrecision(juce::AudioProcessor::singlePrecision);
+
+    //Coefficient design, what updateFilters used to cost on every block
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 40.f;
+        settings.highCutFreq = 16000.f;
+        settings.peakFreq = 2500.f;
+        settings.peakGainInDecibels = 3.f;
+        settings.peakQuality = 0.7f;
+        settings.lowCutSlope = settings.highCutSlope = Slope_48;
+
+        BiquadCoeffs peak;
+        CutCoeffs lowCut, highCut;
+
+        auto stats = measure(10000, 1, [&]
+        {
+            settings.peakFreq = settings.peakFreq < 2600.f ? settings.peakFreq + 1.f : 2500.f;
+            designLowCutFilter(lowCut, settings, 48000.0);
+            designPeakFilter(peak, settings, 48000.0);
+            designHighCutFilter(highCut, settings, 48000.0);
+        });
+
+        std::cout << "coefficient design: " << juce::String(stats.p50, 1) << " ns per full chain (p50)" << std::endl;
+
+        auto* record = new juce::DynamicObject();
+        record->setProperty("benchmark", "designChain");
+        record->setProperty("nsPerDesign", toVar(stats));
+        results.add(juce::var(record));
+    }
+
+    //The analyzer tap, fed on every block of processBlock
+    for (auto blockSize : blockSizes)
+    {
+        juce::AudioBuffer<float> source(numChannels, blockSize);
+        fillWithNoise(source);
+
+        processor.setRateAndBufferSizeDetails(48000.0, blockSize);
+        processor.prepareToPlay(48000.0, blockSize);
+
+        auto stats = measure(juce::jmax(32, samplesPerConfiguration / blockSize), blockSize, [&]
+        {
+            processor.leftChannelFifo.update(source);
+        });
+
+        processor.releaseResources();
+
+        std::cout << "analyzer tap, block " << blockSize << ": " << juce::String(stats.p50, 3) << " ns/sample (p50)" << std::endl;
+
+        auto* record = new juce::DynamicObject();
+        record->setProperty("benchmark", "analyzerTap");
+        record->setProperty("blockSize", blockSize);
+        record->setProperty("nsPerSample", toVar(stats));
+        results.add(juce::var(record));
+    }
+
+    //Analyzer post-processing, the fast kernel against the reference it replaces
+    for (auto fftSize : { 2048, 4096, 8192 })
+    {
+        auto numBins = fftSize / 2;
+        auto scale = 1.f / (float)numBins;
+
+        //Magnitudes from well below the -48 dB floor up to full scale
+        std::vector<float> magnitudes((size_t)numBins), reference, fast;
+        juce::Random random(42);
+        for (auto& m : magnitudes)
+            m = std::pow(10.f, random.nextFloat() * 4.f - 4.f) * (float)numBins;
+
+        auto referenceStats = measure(2000, numBins, [&]
+        {
+            reference = magnitudes;
+            SpectrumKernels::magnitudesToDecibelsReference(reference.data(), numBins, scale, -48.f);
+        });
+
+        auto fastStats = measure(2000, numBins, [&]
+        {
+            fast = magnitudes;
+            SpectrumKernels::magnitudesToDecibels(fast.data(), numBins, scale, -48.f);
+        });
+
+        auto maxError = 0.f;
+        for (size_t i = 0; i < magnitudes.size(); ++i)
+            maxError = juce::jmax(maxError, std::abs(fast[i] - reference[i]));
+
+        std::cout << "spectrum post-processing, fft " << fftSize << ": reference " << juce::String(referenceStats.p50, 3)
+                  << " ns/bin, fast " << juce::String(fastStats.p50, 3) << " ns/bin, max error "
+                  << juce::String(maxError, 4) << " dB" << std::endl;
+
+        auto* record = new juce::DynamicObject();
+        record->setProperty("benchmark", "spectrumPostProcessing");
+        record->setProperty("fftSize", fftSize);
+        record->setProperty("referenceNsPerBin", toVar(referenceStats));
+        record->setProperty("fastNsPerBin", toVar(fastStats));
+        record->setProperty("maxErrorDecibels", maxError);
+        results.add(juce::var(record));
+    }
+
+    //Both engines run the same biquads in the same operation order, so only rounding should tell them apart
+    auto simdEngineMatches = verifySimdEngine(1.0e-4f, results);
+    simdEngineMatches = verifySimdEngine(1.0e-9, results) && simdEngineMatches;
+
+    if (jsonFile != juce::File())
+    {
+        auto* root = new juce::DynamicObject();
+        root->setProperty("cpu", juce::SystemStats::getCpuModel());
+        root->setProperty("results", results);
+
+        if (!jsonFile.replaceWithText(juce::JSON::toString(juce::var(root))))
+        {
+            std::cout << "Can't write " << jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return simdEngineMatches ? 0 : 1;
+}